@@ -18,6 +18,8 @@
  */
 #include "Application.h"
 #include "Logger.h"
+#include "LogView.h"
+#include "LogFileView.h"
 #include "Command.h"
 #include "imgui/imgui.h"
 #include <string>
@@ -44,14 +46,31 @@ namespace ClassGame {
     // Command line input buffer and history
     static char InputBuf[256] = "";
     
-    void ResetGameCounter() {
-        gameActCounter = 0;
+    // Game Log scrolling region and its level filters
+    static LogView logView;
+    
+    // Log file on disk shown in place of the live log, see "Open File"
+    static LogFileView logFileView;
+    static char logFilePath[260] = "game_log.txt";
+    
+    void ResetGameCounter(int value = 0) {
+        gameActCounter = value;
     }
 
     void GameStartUp() {
 
         // Initialize Logger
         Logger::GetInstance().Init();
+        
+        // Up-arrow reaches commands typed in earlier sessions
+        Command::OpenHistory("command_history.txt");
+        
+        // Console commands that need game state
+        Command::RegisterCommand({ .name = "RESET", .usage = "[count:int]", .help = "Reset the game action counter",
+                                   .handler = [](const Command::Args& args) {
+                                       ResetGameCounter((int)args.GetInt("count", 0));
+                                       Logger::GetInstance().Reply(LogLevel::Info, "Game counter reset to %d", gameActCounter);
+                                   } });
 
         // Test log entry types/tags
         LOG_WARN("This is a test warning message");
@@ -93,11 +112,6 @@ namespace ClassGame {
         if (LogWin) {
             ImGui::Begin("Game Log", &LogWin);
 
-            // Filter state variables
-            static bool showInfo = true;
-            static bool showWarning = true;
-            static bool showError = true;
-
             // Options button and popup
             if (ImGui::Button("Options")) {
                 ImGui::OpenPopup("OptionsPopup");
@@ -107,9 +121,22 @@ namespace ClassGame {
                 ImGui::Text("Filter Options");
                 ImGui::Separator();
                 
-                ImGui::Checkbox("Show Info", &showInfo);
-                ImGui::Checkbox("Show Warnings", &showWarning);
-                ImGui::Checkbox("Show Errors", &showError);
+                ImGui::Checkbox("Show Info", &logView.showLevel[(int)LogLevel::Info]);
+                ImGui::Checkbox("Show Warnings", &logView.showLevel[(int)LogLevel::Warning]);
+                ImGui::Checkbox("Show Errors", &logView.showLevel[(int)LogLevel::Error]);
+                
+                // One checkbox per tag seen so far, id 0 is untagged entries
+                Logger& logger = Logger::GetInstance();
+                for (uint16_t tagId = 0; tagId < logger.GetTagCount(); tagId++) {
+                    bool show = logView.IsTagVisible(tagId);
+                    ImGui::PushID(tagId);
+                    if (ImGui::Checkbox(tagId == 0 ? "(no tag)" : logger.GetTagName(tagId).c_str(), &show))
+                        logView.SetTagVisible(tagId, show);
+                    ImGui::PopID();
+                }
+                
+                ImGui::Separator();
+                ImGui::Text("Logger heap allocations: %zu", Logger::GetInstance().GetHeapAllocations());
                 
                 ImGui::Separator();
                 
@@ -120,6 +147,27 @@ namespace ClassGame {
                 ImGui::EndPopup();
             }
 
+            // Browse a log file from disk (plain or .glz) instead of the live history
+            ImGui::SameLine();
+            if (ImGui::Button("Open File")) {
+                ImGui::OpenPopup("OpenFilePopup");
+            }
+            
+            if (ImGui::BeginPopup("OpenFilePopup")) {
+                ImGui::SetNextItemWidth(ImGui::GetFontSize() * 20);
+                bool open = ImGui::InputText("##LogFilePath", logFilePath, IM_ARRAYSIZE(logFilePath),
+                                             ImGuiInputTextFlags_EnterReturnsTrue);
+                ImGui::SameLine();
+                if (ImGui::Button("Open") || open) {
+                    if (Logger::GetInstance().IsActiveLogFile(logFilePath))
+                        LOG_WARN_TAG("The log segment being written can't be opened; wait for it to roll", "LOG");
+                    else if (!logFileView.Open(logFilePath))
+                        LOG_ERROR_TAG("Cannot open log file", "LOG");
+                    ImGui::CloseCurrentPopup();
+                }
+                ImGui::EndPopup();
+            }
+            
             // Test buttons
             ImGui::SameLine();
             if (ImGui::Button("Clear")) {
@@ -137,39 +185,39 @@ namespace ClassGame {
             if (ImGui::Button("Test Error")) {
                 LOG_ERROR("This is a test error message");
             }
-            ImGui::Separator();
-
-            // Display log entries with filtering
-            const auto& entries = Logger::GetInstance().GetEntries();
-            const auto& colors = Logger::GetInstance().GetColors();
-            
-            const float footer_height = ImGui::GetStyle().ItemSpacing.y + ImGui::GetFrameHeightWithSpacing();
-            ImGui::BeginChild("LogScrollRegion", ImVec2(0, -footer_height), true);
             
-            for (size_t i = 0; i < entries.size(); i++) {
-                bool display = true;
-                
-                if (entries[i].find("[INFO]") != std::string::npos && !showInfo) { 
-                    display = false; 
-                }
-                else if (entries[i].find("[WARN]") != std::string::npos && !showWarning) { 
-                    display = false; 
+            // Search box, e.g. "tag:GAME level:warn turn"
+            static char searchBuf[128] = "";
+            if (logFileView.IsOpen()) {
+                if (ImGui::Button("Close File")) {
+                    logFileView.Close();
                 }
-                else if (entries[i].find("[ERROR]") != std::string::npos && !showError) { 
-                    display = false; 
-                }
-                
-                if (display) {
-                    ImGui::PushStyleColor(ImGuiCol_Text, colors[i]);
-                    ImGui::Text("%s", entries[i].c_str());
-                    ImGui::PopStyleColor();
+                else {
+                    ImGui::SameLine();
+                    if (logFileView.IsIndexing())
+                        ImGui::Text("%s: %zu lines, indexing %.0f%%", logFileView.GetPath().c_str(),
+                                    logFileView.LineCount(), logFileView.Progress() * 100.0f);
+                    else
+                        ImGui::Text("%s: %zu lines", logFileView.GetPath().c_str(), logFileView.LineCount());
                 }
             }
-            
-            if (ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) {
-                ImGui::SetScrollHereY(1.0f);
+            else {
+                ImGui::SetNextItemWidth(ImGui::GetFontSize() * 20);
+                ImGui::InputTextWithHint("##Search", "Search (text, tag:NAME, level:LEVEL)", searchBuf, IM_ARRAYSIZE(searchBuf));
+                logView.SetSearch(searchBuf);
+                if (logView.IsSearching()) {
+                    ImGui::SameLine();
+                    ImGui::Text("%zu matches", logView.MatchCount());
+                }
             }
-            ImGui::EndChild();
+            ImGui::Separator();
+
+            // Display log entries with filtering, only the rows in view are drawn
+            const float footer_height = ImGui::GetStyle().ItemSpacing.y + ImGui::GetFrameHeightWithSpacing();
+            if (logFileView.IsOpen())
+                logFileView.Draw("LogScrollRegion", ImVec2(0, -footer_height));
+            else
+                logView.Draw("LogScrollRegion", ImVec2(0, -footer_height));
 
             // Command line input
             ImGui::Separator();
@@ -177,28 +225,42 @@ namespace ClassGame {
 
             ImGuiInputTextFlags input_text_flags = ImGuiInputTextFlags_EnterReturnsTrue | 
                                                    ImGuiInputTextFlags_EscapeClearsAll | 
-                                                   ImGuiInputTextFlags_CallbackHistory;
+                                                   ImGuiInputTextFlags_CallbackHistory |
+                                                   ImGuiInputTextFlags_CallbackCompletion |
+                                                   ImGuiInputTextFlags_CallbackAlways;
             
             if (ImGui::InputText("##CommandInput", InputBuf, IM_ARRAYSIZE(InputBuf), 
                                 input_text_flags, &Command::TextEditCallbackStub)) {
                 char* s = InputBuf;
+                // Enter during a reverse search runs the command it found
+                Command::AcceptReverseSearch(s, IM_ARRAYSIZE(InputBuf));
                 Command::Strtrim(s);
                 if (s[0])
                     Command::ExecCommand(s);
                 strcpy_s(s, IM_ARRAYSIZE(InputBuf), "");
                 reclaim_focus = true;
             }
+            if (!ImGui::IsItemActive() || ImGui::IsKeyPressed(ImGuiKey_Escape))
+                Command::EndReverseSearch();
             
             ImGui::SetItemDefaultFocus();
             if (reclaim_focus)
                 ImGui::SetKeyboardFocusHere(-1);
 
             ImGui::SameLine();
-            ImGui::Text("Command");
+            if (const char* match = Command::ReverseSearchMatch()) {
+                if (match[0])
+                    ImGui::Text("(reverse-i-search): %s", match);
+                else
+                    ImGui::TextDisabled("(failed reverse-i-search)");
+            }
+            else {
+                ImGui::Text("Command");
+            }
 
             ImGui::SameLine();
             if (ImGui::Button("Help")) {
-                LOG_INFO_TAG("Available commands: CLEAR, HELP, INFO, WARN, ERROR, RESET", "CMD");
+                Command::LogHelp();
             }
 
             ImGui::End();
@@ -235,8 +297,7 @@ namespace ClassGame {
 
         if (ImGui::Button("Game Action")) {
             gameActCounter++;
-            std::string msg = "Game action performed, counter: " + std::to_string(gameActCounter);
-            LOG_INFO_TAG(msg, "GAME");
+            LOG_INFOF_TAG("GAME", "Game action performed, counter: %d", gameActCounter);
         }
         ImGui::SameLine();
         ImGui::Text("counter: %d", gameActCounter);
@@ -264,10 +325,22 @@ namespace ClassGame {
             ImGui::Text("Hello from another window!");
             ImGui::End();
         }
+
+        // Frame boundary for the logger's flush policy
+        Logger::GetInstance().EndFrame();
     }
 
     void EndOfTurn() {
         gameActCounter++;
-        LOG_INFO_TAG("End of turn #" + std::to_string(gameActCounter), "GAME");
+        LOG_INFOF_TAG("GAME", "End of turn #%d", gameActCounter);
+    }
+
+    void GameShutDown() {
+        LOG_INFO("Game shutting down");
+
+        // Stop indexing any open log file, then drain the async writer before the process exits
+        logFileView.Close();
+        Command::CloseHistory();
+        Logger::GetInstance().Shutdown();
     }
 }
\ No newline at end of file
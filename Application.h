@@ -4,4 +4,5 @@ namespace ClassGame {
     void GameStartUp();
     void RenderGame();
     void EndOfTurn();
+    void GameShutDown();
 }
\ No newline at end of file
@@ -1,18 +1,65 @@
 #include "Command.h"
+#include "CommandHistory.h"
+#include "CommandTrie.h"
 #include "Logger.h"
-#include "Application.h"
+#include "LogFormat.h"
 #include <string>
+#include <vector>
+#include <deque>
 #include <cctype>
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <climits>
+#include <charconv>
+#include <algorithm>
 
 namespace ClassGame {
     namespace Command {
         
-        // Static variables for command history
-        static ImVector<char*> CommandHistory;
+        // Static variables for command history; HistoryPos is the entry shown, -1 a new line
+        static CommandHistory History;
         static int HistoryPos = -1;
         
+        // Registered commands, in registration order for HELP. A deque so a handler that
+        // registers another command doesn't move the one running.
+        struct RegisteredCommand {
+            std::string name;
+            std::string aliases;
+            std::string usage;
+            std::string help;
+            std::vector<ArgParam> params;
+            Handler handler;
+        };
+        static std::deque<RegisteredCommand> Commands;
+        
+        // Names and aliases, found through an open-addressing table of case-folded hashes.
+        // A slot holds a key index + 1, 0 is empty; the table stays at most half full.
+        struct CommandKey {
+            uint32_t hash;
+            uint32_t command;
+            std::string name;
+        };
+        static std::vector<CommandKey> CommandKeys;
+        static std::vector<uint32_t> KeySlots;
+        static CommandTrie KeyTrie;             // The same keys by prefix, for tab completion
+        static bool BuiltinsRegistered = false;
+        
+        // Tab completion: the candidates from the last Tab, which further Tabs cycle through as
+        // long as the line is still what the last one left
+        static constexpr size_t MaxCompletions = 32;
+        static std::vector<std::string> Completions;
+        static size_t CompletionIndex = 0;
+        static int CompletionStart = 0;
+        static std::string CompletionShown;
+        
+        // Reverse search (Ctrl+R): the input line is the query and SearchMatch the history entry
+        // found for it, -1 none
+        static bool Searching = false;
+        static std::string SearchQuery;
+        static int SearchMatch = -1;
+        
         // Case-insensitive string compare
         int Stricmp(const char* s1, const char* s2) { 
             int d; 
@@ -49,67 +96,820 @@ namespace ClassGame {
             *str_end = 0; 
         }
         
+        static bool IsSpace(char c) {
+            return c == ' ' || c == '\t';
+        }
+        
+        static bool IsKeyChar(char c) {
+            return isalnum((unsigned char)c) || c == '_';
+        }
+        
+        // Quoted text starting at the '"' at pos; an unclosed quote runs to the end of the line.
+        // Returns the position after the closing quote.
+        static size_t ReadQuoted(std::string_view line, size_t pos, std::string_view& text) {
+            size_t close = line.find('"', pos + 1);
+            if (close == std::string_view::npos) {
+                text = line.substr(pos + 1);
+                return line.size();
+            }
+            text = line.substr(pos + 1, close - pos - 1);
+            return close + 1;
+        }
+        
+        static size_t SkipWord(std::string_view line, size_t pos) {
+            while (pos < line.size() && !IsSpace(line[pos]))
+                pos++;
+            return pos;
+        }
+        
+        int Tokenize(std::string_view line, Token* tokens, int maxTokens, bool* truncated) {
+            if (truncated)
+                *truncated = false;
+            int count = 0;
+            size_t pos = 0;
+            for (;;) {
+                while (pos < line.size() && IsSpace(line[pos]))
+                    pos++;
+                if (pos == line.size())
+                    break;
+                if (count == maxTokens) {
+                    if (truncated)
+                        *truncated = true;
+                    break;
+                }
+                
+                Token& token = tokens[count++];
+                token = Token();
+                size_t start = pos;
+                if (line[pos] == '"') {
+                    token.quoted = true;
+                    pos = ReadQuoted(line, pos, token.text);
+                }
+                else {
+                    while (pos < line.size() && IsKeyChar(line[pos]))
+                        pos++;
+                    if (pos > start && pos < line.size() && line[pos] == '=') {
+                        token.key = line.substr(start, pos - start);
+                        size_t value = ++pos;
+                        if (pos < line.size() && line[pos] == '"') {
+                            token.quoted = true;
+                            pos = ReadQuoted(line, pos, token.text);
+                        }
+                        else {
+                            pos = SkipWord(line, pos);
+                            token.text = line.substr(value, pos - value);
+                        }
+                    }
+                    else {
+                        pos = SkipWord(line, pos);
+                        token.text = line.substr(start, pos - start);
+                    }
+                }
+                token.raw = line.substr(start, pos - start);
+            }
+            return count;
+        }
+        
+        bool ParseInt(std::string_view text, int64_t& value) {
+            if (!text.empty() && text[0] == '+')
+                text.remove_prefix(1);
+            auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+            return !text.empty() && result.ec == std::errc() && result.ptr == text.data() + text.size();
+        }
+        
+        // strtod rather than from_chars, which not every standard library has for double
+        bool ParseFloat(std::string_view text, double& value) {
+            if (!text.empty() && text[0] == '+')
+                text.remove_prefix(1);
+            char buffer[64];
+            if (text.empty() || text.size() >= sizeof(buffer) || isspace((unsigned char)text[0]))
+                return false;
+            memcpy(buffer, text.data(), text.size());
+            buffer[text.size()] = '\0';
+            char* end = nullptr;
+            errno = 0;
+            value = strtod(buffer, &end);
+            return end == buffer + text.size() && errno != ERANGE;
+        }
+        
+        static bool SameName(std::string_view a, std::string_view b) {
+            return a.size() == b.size() && Strnicmp(a.data(), b.data(), (int)a.size()) == 0;
+        }
+        
+        static bool IsChoice(std::string_view choices, std::string_view text) {
+            while (!choices.empty()) {
+                size_t bar = choices.find('|');
+                if (SameName(choices.substr(0, bar), text))
+                    return true;
+                if (bar == std::string_view::npos)
+                    break;
+                choices.remove_prefix(bar + 1);
+            }
+            return false;
+        }
+        
+        // "<name>", "[name:int]", "[level:INFO|WARN]", "[message...]"
+        static bool ParseSchema(std::string_view usage, std::vector<ArgParam>& params) {
+            Token tokens[Args::MaxParams];
+            bool truncated;
+            int count = Tokenize(usage, tokens, Args::MaxParams, &truncated);
+            if (truncated)
+                return false;
+            for (int i = 0; i < count; i++) {
+                std::string_view word = tokens[i].raw;
+                ArgParam param;
+                if (word.size() < 3 || !((word.front() == '<' && word.back() == '>') || (word.front() == '[' && word.back() == ']')))
+                    return false;
+                param.optional = word.front() == '[';
+                std::string_view inner = word.substr(1, word.size() - 2);
+                if (inner.size() > 3 && inner.substr(inner.size() - 3) == "...") {
+                    param.rest = true;
+                    inner.remove_suffix(3);
+                }
+                size_t colon = inner.find(':');
+                std::string_view type = colon == std::string_view::npos ? std::string_view() : inner.substr(colon + 1);
+                param.name = inner.substr(0, colon);
+                if (type == "int")
+                    param.type = ArgType::Int;
+                else if (type == "float")
+                    param.type = ArgType::Float;
+                else if (!type.empty() && type != "str") {
+                    param.type = ArgType::Choice;
+                    param.choices = type;
+                }
+                
+                if (param.name.empty() || (param.rest && (param.type != ArgType::String || i != count - 1)))
+                    return false;
+                for (const ArgParam& other : params) {
+                    if (SameName(other.name, param.name))
+                        return false;
+                }
+                params.push_back(std::move(param));
+            }
+            return true;
+        }
+        
+        int Args::Find(std::string_view name) const {
+            for (int i = 0; params && i < (int)params->size(); i++) {
+                if (SameName((*params)[i].name, name))
+                    return i;
+            }
+            return -1;
+        }
+        
+        bool Args::Has(std::string_view name) const {
+            int i = Find(name);
+            return i >= 0 && bound[i];
+        }
+        
+        std::string_view Args::Get(std::string_view name, std::string_view fallback) const {
+            int i = Find(name);
+            return i >= 0 && bound[i] ? values[i] : fallback;
+        }
+        
+        int64_t Args::GetInt(std::string_view name, int64_t fallback) const {
+            int i = Find(name);
+            return i >= 0 && bound[i] ? ints[i] : fallback;
+        }
+        
+        double Args::GetFloat(std::string_view name, double fallback) const {
+            int i = Find(name);
+            return i >= 0 && bound[i] ? floats[i] : fallback;
+        }
+        
+        bool Args::Bind(std::string_view text, const std::vector<ArgParam>& paramList, char* error, size_t errorSize) {
+            raw = text;
+            params = &paramList;
+            int paramCount = (int)paramList.size();
+            for (int i = 0; i < MaxParams; i++)
+                bound[i] = false;
+            
+            Token tokens[MaxTokens];
+            bool truncated;
+            int count = Tokenize(text, tokens, MaxTokens, &truncated);
+            
+            // name=value binds by name; anything else, including key=value for an unknown
+            // key, is positional
+            int positional[MaxTokens];
+            int positionalCount = 0;
+            for (int i = 0; i < count; i++) {
+                int param = tokens[i].key.empty() ? -1 : Find(tokens[i].key);
+                if (param < 0) {
+                    positional[positionalCount++] = i;
+                    continue;
+                }
+                if (bound[param]) {
+                    snprintf(error, errorSize, "%s given twice", paramList[param].name.c_str());
+                    return false;
+                }
+                values[param] = tokens[i].text;
+                bound[param] = true;
+            }
+            
+            // Required parameters take words first; what's left fills the optional ones in order
+            int required = 0;
+            int optional = 0;
+            for (int i = 0; i < paramCount; i++) {
+                if (!bound[i] && !paramList[i].rest)
+                    (paramList[i].optional ? optional : required)++;
+            }
+            int fill = std::clamp(positionalCount - required, 0, optional);
+            bool takes[MaxParams] = {};
+            for (int i = 0; i < paramCount; i++) {
+                if (bound[i] || paramList[i].rest)
+                    continue;
+                takes[i] = !paramList[i].optional || fill-- > 0;
+            }
+            
+            int next = 0;
+            for (int i = 0; i < paramCount && next < positionalCount; i++) {
+                if (bound[i])
+                    continue;
+                if (paramList[i].rest) {
+                    // A single quoted word loses its quotes; otherwise the line as typed
+                    const Token& first = tokens[positional[next]];
+                    if (next == positionalCount - 1 && !truncated) {
+                        values[i] = first.key.empty() ? first.text : first.raw;
+                    }
+                    else {
+                        values[i] = text.substr((size_t)(first.raw.data() - text.data()));
+                        while (!values[i].empty() && IsSpace(values[i].back()))
+                            values[i].remove_suffix(1);
+                    }
+                    bound[i] = true;
+                    next = positionalCount;
+                    truncated = false;
+                }
+                else if (takes[i]) {
+                    const Token& token = tokens[positional[next++]];
+                    values[i] = token.key.empty() ? token.text : token.raw;
+                    bound[i] = true;
+                }
+            }
+            if (next < positionalCount || truncated) {
+                snprintf(error, errorSize, paramCount == 0 ? "takes no arguments" : "too many arguments");
+                return false;
+            }
+            
+            for (int i = 0; i < paramCount; i++) {
+                const ArgParam& param = paramList[i];
+                if (!bound[i]) {
+                    if (!param.optional) {
+                        snprintf(error, errorSize, "missing %s", param.name.c_str());
+                        return false;
+                    }
+                    continue;
+                }
+                bool valid = true;
+                if (param.type == ArgType::Int)
+                    valid = ParseInt(values[i], ints[i]);
+                else if (param.type == ArgType::Float)
+                    valid = ParseFloat(values[i], floats[i]);
+                else if (param.type == ArgType::Choice)
+                    valid = IsChoice(param.choices, values[i]);
+                if (!valid) {
+                    const char* expected = param.type == ArgType::Int ? "a whole number" :
+                                           param.type == ArgType::Float ? "a number" : param.choices.c_str();
+                    snprintf(error, errorSize, "%s must be %s%s, not '%.*s'", param.name.c_str(),
+                             param.type == ArgType::Choice ? "one of " : "", expected, (int)values[i].size(), values[i].data());
+                    return false;
+                }
+                if (param.type == ArgType::Int && (ints[i] < INT_MIN || ints[i] > INT_MAX)) {
+                    snprintf(error, errorSize, "%s must be between %d and %d, not '%.*s'", param.name.c_str(),
+                             INT_MIN, INT_MAX, (int)values[i].size(), values[i].data());
+                    return false;
+                }
+            }
+            return true;
+        }
+        
+        // FNV-1a over the upper-cased name
+        static uint32_t FoldedHash(std::string_view name) {
+            uint32_t hash = 2166136261u;
+            for (char c : name) {
+                hash ^= (uint32_t)toupper((unsigned char)c);
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+        
+        static const RegisteredCommand* FindCommand(std::string_view name) {
+            if (KeySlots.empty())
+                return nullptr;
+            uint32_t hash = FoldedHash(name);
+            size_t mask = KeySlots.size() - 1;
+            for (size_t slot = hash & mask; KeySlots[slot] != 0; slot = (slot + 1) & mask) {
+                const CommandKey& key = CommandKeys[KeySlots[slot] - 1];
+                if (key.hash == hash && SameName(key.name, name))
+                    return &Commands[key.command];
+            }
+            return nullptr;
+        }
+        
+        static void InsertKeySlot(uint32_t keyIndex) {
+            size_t mask = KeySlots.size() - 1;
+            size_t slot = CommandKeys[keyIndex].hash & mask;
+            while (KeySlots[slot] != 0)
+                slot = (slot + 1) & mask;
+            KeySlots[slot] = keyIndex + 1;
+        }
+        
+        static void AddKey(std::string_view name, uint32_t command) {
+            CommandKeys.push_back({ FoldedHash(name), command, std::string(name) });
+            KeyTrie.Insert(name, (uint32_t)CommandKeys.size() - 1);
+            if (CommandKeys.size() * 2 > KeySlots.size()) {
+                KeySlots.assign(KeySlots.empty() ? 32 : KeySlots.size() * 2, 0);
+                for (uint32_t i = 0; i < (uint32_t)CommandKeys.size(); i++)
+                    InsertKeySlot(i);
+            }
+            else {
+                InsertKeySlot((uint32_t)CommandKeys.size() - 1);
+            }
+        }
+        
+        // LOGLEVEL [tag] [level]: no arguments lists the levels, a lone word is the global level,
+        // tag level DEFAULT drops the override
+        static void LogLevelCommand(const Args& args) {
+            Logger& logger = Logger::GetInstance();
+            bool hasTag = args.Has("tag") && args.Has("level");
+            std::string_view tag = hasTag ? args.Get("tag") : std::string_view();
+            std::string_view levelName = args.Has("level") ? args.Get("level") : args.Get("tag");
+            LogLevel level;
+            if (!args.Has("level") && !args.Has("tag")) {
+                logger.Reply(LogLevel::Info, "Log level: %s", GetLevelName(logger.GetMinLevel()));
+                for (uint16_t i = 1; i < logger.GetTagCount(); i++) {
+                    logger.Reply(LogLevel::Info, "  [%s] %s", logger.GetTagName(i).c_str(),
+                                 GetLevelName(logger.GetTagLevel(logger.GetTagName(i))));
+                }
+            }
+            else if (SameName(levelName, "DEFAULT")) {
+                if (hasTag) {
+                    logger.ClearTagLevel(tag);
+                    logger.Reply(LogLevel::Warning, "[%.*s] uses the global log level", (int)tag.size(), tag.data());
+                }
+                else {
+                    logger.Reply(LogLevel::Error, "LOGLEVEL: DEFAULT only applies to a tag");
+                }
+            }
+            else if (ParseLevelName(levelName, level)) {
+                if (hasTag) {
+                    logger.SetTagLevel(tag, level);
+                    logger.Reply(LogLevel::Warning, "[%.*s] log level set to %s", (int)tag.size(), tag.data(), GetLevelName(level));
+                }
+                else {
+                    logger.SetMinLevel(level);
+                    logger.Reply(LogLevel::Warning, "Log level set to %s", GetLevelName(level));
+                }
+            }
+            else {
+                logger.Reply(LogLevel::Error, "LOGLEVEL: '%.*s' is not a level", (int)levelName.size(), levelName.data());
+            }
+        }
+        
+        // LOGROUTE <tag> [route] [level]: lowest level of the tag that reaches that output. With
+        // just a tag, lists its routes.
+        static void LogRouteCommand(const Args& args) {
+            static const char* routeNames[] = { "FILE", "CONSOLE", "HISTORY" };
+            Logger& logger = Logger::GetInstance();
+            std::string_view tag = args.Get("tag");
+            int route = -1;
+            for (int i = 0; i < (int)LogRoute::Count; i++) {
+                if (SameName(args.Get("route"), routeNames[i]))
+                    route = i;
+            }
+            LogLevel level;
+            if (!args.Has("route") && !args.Has("level")) {
+                for (int i = 0; i < (int)LogRoute::Count; i++) {
+                    logger.Reply(LogLevel::Info, "[%.*s] %s: %s", (int)tag.size(), tag.data(), routeNames[i],
+                                 GetLevelName(logger.GetTagRoute(tag, (LogRoute)i)));
+                }
+            }
+            else if (route >= 0 && ParseLevelName(args.Get("level"), level)) {
+                logger.SetTagRoute(tag, (LogRoute)route, level);
+                logger.Reply(LogLevel::Warning, "[%.*s] %s route set to %s", (int)tag.size(), tag.data(),
+                             routeNames[route], GetLevelName(level));
+            }
+            else {
+                logger.Reply(LogLevel::Error, "LOGROUTE: give both a route and a level");
+            }
+        }
+        
+        // INFO/WARN/ERROR [message...]: log the message, or a test one
+        static void LogMessageCommand(LogLevel level, const Args& args, const char* fallback) {
+            std::string_view message = args.Get("message", fallback);
+            (void)message;      // Unused when LOG_COMPILE_LEVEL strips all three
+            if (level == LogLevel::Info)
+                LOG_INFO(message);
+            else if (level == LogLevel::Warning)
+                LOG_WARN(message);
+            else
+                LOG_ERROR(message);
+        }
+        
+        static void RegisterBuiltins() {
+            if (BuiltinsRegistered)
+                return;
+            BuiltinsRegistered = true;
+            
+            RegisterCommand({ .name = "CLEAR", .aliases = "CLS", .help = "Clear the Game Log",
+                              .handler = [](const Args&) {
+                                  Logger::GetInstance().Clear();
+                                  Logger::GetInstance().Reply(LogLevel::Info, "Log cleared via command");
+                              } });
+            RegisterCommand({ .name = "HELP", .aliases = "?", .usage = "[command]",
+                              .help = "List the commands, or describe one",
+                              .handler = [](const Args& args) { LogHelp(args.Get("command")); } });
+            RegisterCommand({ .name = "INFO", .usage = "[message...]", .help = "Log an info message",
+                              .handler = [](const Args& args) {
+                                  LogMessageCommand(LogLevel::Info, args, "Test info message from command line");
+                              } });
+            RegisterCommand({ .name = "WARN", .usage = "[message...]", .help = "Log a warning",
+                              .handler = [](const Args& args) {
+                                  LogMessageCommand(LogLevel::Warning, args, "Test warning message from command line");
+                              } });
+            RegisterCommand({ .name = "ERROR", .usage = "[message...]", .help = "Log an error",
+                              .handler = [](const Args& args) {
+                                  LogMessageCommand(LogLevel::Error, args, "Test error message from command line");
+                              } });
+            RegisterCommand({ .name = "LOGLEVEL", .usage = "[tag] [level:INFO|WARN|ERROR|OFF|DEFAULT]",
+                              .help = "Show or set the global or a tag's log level", .handler = LogLevelCommand });
+            RegisterCommand({ .name = "LOGROUTE", .usage = "<tag> [route:FILE|CONSOLE|HISTORY] [level:INFO|WARN|ERROR|OFF]",
+                              .help = "Show or set which levels of a tag reach each output", .handler = LogRouteCommand });
+        }
+        
+        bool RegisterCommand(const CommandSpec& spec) {
+            RegisterBuiltins();
+            if (!spec.name || !spec.name[0] || !spec.handler)
+                return false;
+            
+            Token names[8];
+            int count = 1 + Tokenize(spec.aliases ? spec.aliases : "", names + 1, 7);
+            names[0].text = spec.name;
+            for (int i = 0; i < count; i++) {
+                if (FindCommand(names[i].text))
+                    return false;
+            }
+            std::vector<ArgParam> params;
+            if (!ParseSchema(spec.usage ? spec.usage : "", params))
+                return false;
+            
+            uint32_t command = (uint32_t)Commands.size();
+            Commands.push_back({ spec.name, spec.aliases ? spec.aliases : "", spec.usage ? spec.usage : "",
+                                 spec.help ? spec.help : "", std::move(params), spec.handler });
+            for (int i = 0; i < count; i++)
+                AddKey(names[i].text, command);
+            return true;
+        }
+        
+        void LogHelp(std::string_view command) {
+            RegisterBuiltins();
+            Logger& logger = Logger::GetInstance();
+            while (!command.empty() && command.front() == ' ')
+                command.remove_prefix(1);
+            while (!command.empty() && command.back() == ' ')
+                command.remove_suffix(1);
+            
+            if (command.empty()) {
+                std::string names;
+                for (const RegisteredCommand& registered : Commands) {
+                    if (!names.empty())
+                        names += ", ";
+                    names += registered.name;
+                }
+                logger.Reply(LogLevel::Info, "Available commands: %s (HELP <command> for details)", names.c_str());
+                return;
+            }
+            
+            const RegisteredCommand* registered = FindCommand(command);
+            if (!registered) {
+                logger.Reply(LogLevel::Error, "Unknown command: '%.*s'", (int)command.size(), command.data());
+                return;
+            }
+            logger.Reply(LogLevel::Info, "%s%s%s - %s", registered->name.c_str(), registered->usage.empty() ? "" : " ",
+                         registered->usage.c_str(), registered->help.c_str());
+            if (!registered->aliases.empty())
+                logger.Reply(LogLevel::Info, "  Also: %s", registered->aliases.c_str());
+        }
+        
         // Execute command from command line
         void ExecCommand(const char* command_line) {
-            LOG_INFO_TAG(std::string("Command: ") + command_line, "CMD");
+            Logger& logger = Logger::GetInstance();
+            logger.Reply(LogLevel::Info, "Command: %s", command_line);
             
-            // Add to history (remove duplicates)
+            // Add to history, an earlier identical command moves to the end
             HistoryPos = -1;
-            for (int i = CommandHistory.Size - 1; i >= 0; i--) {
-                if (Stricmp(CommandHistory[i], command_line) == 0) {
-                    free(CommandHistory[i]);
-                    CommandHistory.erase(CommandHistory.begin() + i);
-                    break;
-                }
+            History.Add(command_line);
+            
+            // Look up the first word; the rest is the command's arguments
+            RegisterBuiltins();
+            std::string_view line(command_line);
+            size_t nameStart = 0;
+            while (nameStart < line.size() && IsSpace(line[nameStart]))
+                nameStart++;
+            size_t nameEnd = SkipWord(line, nameStart);
+            const RegisteredCommand* command = FindCommand(line.substr(nameStart, nameEnd - nameStart));
+            if (!command) {
+                logger.Reply(LogLevel::Error, "Unknown command: '%s'", command_line);
+                return;
             }
-            CommandHistory.push_back(Strdup(command_line));
             
-            // Process commands
-            if (Stricmp(command_line, "CLEAR") == 0) {
-                Logger::GetInstance().Clear();
-                LOG_INFO_TAG("Log cleared via command", "CMD");
+            Args args;
+            char error[128];
+            if (!args.Bind(line.substr(nameEnd), command->params, error, sizeof(error))) {
+                logger.Reply(LogLevel::Error, "%s: %s. Usage: %s%s%s", command->name.c_str(), error, command->name.c_str(),
+                             command->usage.empty() ? "" : " ", command->usage.c_str());
+                return;
             }
-            else if (Stricmp(command_line, "HELP") == 0) {
-                LOG_INFO_TAG("Available commands: CLEAR, HELP, INFO, WARN, ERROR, RESET", "CMD");
+            command->handler(args);
+        }
+        
+        // How well query fuzzy-matches text: its characters must all appear in order, ignoring
+        // case. Consecutive runs and matches at the start of a word score higher, and skipped
+        // characters cost a little. -1 if it doesn't match.
+        static int FuzzyScore(std::string_view query, std::string_view text) {
+            int score = 0;
+            size_t at = 0;
+            size_t previous = std::string_view::npos;
+            for (char q : query) {
+                size_t start = at;
+                char lower = (char)tolower((unsigned char)q);
+                char upper = (char)toupper((unsigned char)q);
+                while (at < text.size() && text[at] != lower && text[at] != upper)
+                    at++;
+                if (at == text.size())
+                    return -1;
+                score += 1;
+                if (previous != std::string_view::npos && at == previous + 1)
+                    score += 4;
+                if (at == 0 || !IsKeyChar(text[at - 1]))
+                    score += 6;
+                score -= (int)std::min<size_t>(at - start, 3);
+                previous = at++;
             }
-            else if (Stricmp(command_line, "RESET") == 0) {
-                // Access gameActCounter through a function in Application
-                // For now, just log it
-                LOG_INFO_TAG("Game counter reset", "CMD");
+            return score;
+        }
+        
+        // Keeps the best MaxCompletions by score, highest first; earlier ones win ties
+        static void KeepBest(std::vector<std::pair<int, int>>& best, int score, int item) {
+            if (best.size() == MaxCompletions && score <= best.back().first)
+                return;
+            auto at = std::upper_bound(best.begin(), best.end(), score,
+                                       [](int s, const std::pair<int, int>& b) { return s > b.first; });
+            best.insert(at, { score, item });
+            if (best.size() > MaxCompletions)
+                best.pop_back();
+        }
+        
+        static size_t CommonLength(std::string_view a, std::string_view b) {
+            size_t length = 0;
+            while (length < a.size() && length < b.size() &&
+                   toupper((unsigned char)a[length]) == toupper((unsigned char)b[length]))
+                length++;
+            return length;
+        }
+        
+        // Command names for a partly typed first word: the ones starting with it, from the trie,
+        // or failing that the ones it fuzzy-matches, best first. Returns how far all the names
+        // starting with it agree, 0 for fuzzy matches.
+        static size_t NameCompletions(std::string_view word) {
+            Completions.clear();
+            std::vector<uint32_t> keys;
+            KeyTrie.Collect(word, keys, MaxCompletions);
+            for (uint32_t key : keys)
+                Completions.push_back(CommandKeys[key].name);
+            if (!Completions.empty())
+                return KeyTrie.CommonPrefix(word);
+            
+            std::vector<std::pair<int, int>> best;
+            for (size_t key = 0; key < CommandKeys.size(); key++) {
+                int score = FuzzyScore(word, CommandKeys[key].name);
+                if (score >= 0)
+                    KeepBest(best, score, (int)key);
             }
-            else if (Stricmp(command_line, "INFO") == 0) {
-                LOG_INFO("Test info message from command line");
+            for (const auto& [score, key] : best)
+                Completions.push_back(CommandKeys[key].name);
+            return 0;
+        }
+        
+        static bool Continues(std::string_view text, std::string_view line) {
+            return text.size() > line.size() && SameName(text.substr(0, line.size()), line);
+        }
+        
+        // Earlier commands for a partly typed line, newest first: the ones that continue it, or
+        // failing that the ones it fuzzy-matches, best first. History is a fixed-size pool, so
+        // this is one pass over at most its capacity whatever the file holds.
+        static size_t HistoryCompletions(std::string_view line) {
+            Completions.clear();
+            
+            // Reach back into earlier sessions only while there are too few candidates. Loaded
+            // commands stay in memory, so the file is read through at most once a session.
+            size_t matches = 0;
+            for (int entry = History.Newest(); entry != -1; entry = History.Older(entry))
+                matches += Continues(History.Text(entry), line);
+            while (matches < MaxCompletions && History.LoadOlder())
+                matches += Continues(History.Text(History.Oldest()), line);
+            
+            std::string_view first;
+            size_t common = 0;
+            for (int entry = History.Newest(); entry != -1; entry = History.Older(entry)) {
+                std::string_view text = History.Text(entry);
+                if (!Continues(text, line))
+                    continue;
+                common = first.empty() ? text.size() : std::min(common, CommonLength(first, text));
+                if (first.empty())
+                    first = text;
+                if (Completions.size() < MaxCompletions)
+                    Completions.emplace_back(text);
+            }
+            if (!Completions.empty())
+                return common;
+            
+            std::vector<std::pair<int, int>> best;
+            for (int entry = History.Newest(); entry != -1; entry = History.Older(entry)) {
+                int score = FuzzyScore(line, History.Text(entry));
+                if (score >= 0)
+                    KeepBest(best, score, entry);
             }
-            else if (Stricmp(command_line, "WARN") == 0) {
-                LOG_WARN("Test warning message from command line");
+            for (const auto& [score, entry] : best)
+                Completions.emplace_back(History.Text(entry));
+            return 0;
+        }
+        
+        static void ReplaceText(ImGuiInputTextCallbackData* data, int start, int end, std::string_view text) {
+            data->DeleteChars(start, end - start);
+            data->InsertChars(start, text.data(), text.data() + text.size());
+        }
+        
+        // Tab: in the first word, complete the command name; after it, the whole line from
+        // history. A single candidate is filled in, several that agree past what's typed are
+        // filled in that far, and otherwise they're listed and each further Tab shows the next.
+        static void CompleteInput(ImGuiInputTextCallbackData* data) {
+            std::string_view buffer(data->Buf, (size_t)data->BufTextLen);
+            if (!Completions.empty() && buffer == CompletionShown) {
+                int end = CompletionStart + (int)Completions[CompletionIndex].size();
+                CompletionIndex = (CompletionIndex + 1) % Completions.size();
+                ReplaceText(data, CompletionStart, end, Completions[CompletionIndex]);
+                CompletionShown.assign(data->Buf, (size_t)data->BufTextLen);
+                return;
             }
-            else if (Stricmp(command_line, "ERROR") == 0) {
-                LOG_ERROR("Test error message from command line");
+            
+            RegisterBuiltins();
+            std::string_view typed = buffer.substr(0, (size_t)data->CursorPos);
+            size_t start = 0;
+            while (start < typed.size() && IsSpace(typed[start]))
+                start++;
+            bool naming = SkipWord(typed, start) == typed.size();
+            std::string_view word = typed.substr(start);
+            size_t common = naming ? NameCompletions(word) : HistoryCompletions(word);
+            int end = naming ? (int)SkipWord(buffer, typed.size()) : data->BufTextLen;
+            if (Completions.empty())
+                return;
+            
+            if (Completions.size() == 1) {
+                std::string text = Completions[0];
+                if (naming && (end == data->BufTextLen || !IsSpace(data->Buf[end])))
+                    text += ' ';
+                ReplaceText(data, (int)start, end, text);
+                Completions.clear();
+                return;
             }
-            else {
-                LOG_ERROR_TAG(std::string("Unknown command: '") + command_line + "'", "CMD");
+            if (common > word.size()) {
+                ReplaceText(data, (int)start, end, std::string_view(Completions[0]).substr(0, common));
+                Completions.clear();
+                return;
+            }
+            
+            std::string list;
+            for (size_t i = 0; i < Completions.size() && i < 8; i++) {
+                if (!list.empty())
+                    list += naming ? ", " : " | ";
+                list += Completions[i];
+            }
+            if (Completions.size() > 8)
+                list += " ...";
+            Logger::GetInstance().Reply(LogLevel::Info, "Possible matches: %s", list.c_str());
+            CompletionIndex = 0;
+            CompletionStart = (int)start;
+            ReplaceText(data, (int)start, end, Completions[0]);
+            CompletionShown.assign(data->Buf, (size_t)data->BufTextLen);
+        }
+        
+        // Case-insensitive substring test; only places where the first character matches get
+        // compared in full
+        static bool ContainsFolded(std::string_view text, std::string_view query) {
+            if (query.empty())
+                return true;
+            char lower = (char)tolower((unsigned char)query[0]);
+            char upper = (char)toupper((unsigned char)query[0]);
+            for (size_t i = 0; i + query.size() <= text.size(); i++) {
+                if ((text[i] == lower || text[i] == upper) && SameName(text.substr(i, query.size()), query))
+                    return true;
+            }
+            return false;
+        }
+        
+        // The next entry older than from (the newest for -1) containing the query, reading
+        // earlier sessions' commands in from the history file once the ones in memory run out
+        static int SearchOlder(int from) {
+            int entry = from == -1 ? History.Newest() : History.Older(from);
+            for (;;) {
+                if (entry == -1) {
+                    int oldest = History.Oldest();
+                    if (!History.LoadOlder())
+                        return -1;
+                    entry = oldest == -1 ? History.Newest() : History.Older(oldest);
+                }
+                if (ContainsFolded(History.Text(entry), SearchQuery))
+                    return entry;
+                entry = History.Older(entry);
+            }
+        }
+        
+        // Ctrl+R starts a search for what's on the line, or steps to an older match; editing the
+        // line searches again from the newest command
+        static void UpdateReverseSearch(ImGuiInputTextCallbackData* data) {
+            std::string_view query(data->Buf, (size_t)data->BufTextLen);
+            if (ImGui::IsKeyChordPressed(ImGuiMod_Ctrl | ImGuiKey_R)) {
+                if (!Searching) {
+                    Searching = true;
+                    SearchQuery.assign(query);
+                    SearchMatch = SearchOlder(-1);
+                }
+                else if (SearchMatch != -1) {
+                    int older = SearchOlder(SearchMatch);
+                    if (older != -1)
+                        SearchMatch = older;
+                }
+            }
+            else if (Searching && query != SearchQuery) {
+                SearchQuery.assign(query);
+                SearchMatch = SearchOlder(-1);
+            }
+        }
+        
+        // Tab or an arrow during a search puts the match on the line for editing
+        static void FinishReverseSearch(ImGuiInputTextCallbackData* data) {
+            if (SearchMatch != -1) {
+                ReplaceText(data, 0, data->BufTextLen, History.Text(SearchMatch));
+                HistoryPos = SearchMatch;
             }
+            EndReverseSearch();
+        }
+        
+        const char* ReverseSearchMatch() {
+            if (!Searching)
+                return nullptr;
+            return SearchMatch != -1 ? History.Text(SearchMatch) : "";
         }
         
-        // Callback for input text - handles command history navigation
+        void AcceptReverseSearch(char* buf, size_t size) {
+            if (Searching && SearchMatch != -1)
+                snprintf(buf, size, "%s", History.Text(SearchMatch));
+            EndReverseSearch();
+        }
+        
+        void EndReverseSearch() {
+            Searching = false;
+            SearchQuery.clear();
+            SearchMatch = -1;
+        }
+        
+        // Callback for input text - history navigation, tab completion and reverse search
         int TextEditCallbackStub(ImGuiInputTextCallbackData* data) {
             switch (data->EventFlag) {
+                case ImGuiInputTextFlags_CallbackAlways:
+                    UpdateReverseSearch(data);
+                    break;
+                case ImGuiInputTextFlags_CallbackCompletion:
+                    if (Searching)
+                        FinishReverseSearch(data);
+                    else
+                        CompleteInput(data);
+                    break;
                 case ImGuiInputTextFlags_CallbackHistory: {
+                    if (Searching) {
+                        FinishReverseSearch(data);
+                        break;
+                    }
                     const int prev_history_pos = HistoryPos;
                     if (data->EventKey == ImGuiKey_UpArrow) {
-                        if (HistoryPos == -1)
-                            HistoryPos = CommandHistory.Size - 1;
-                        else if (HistoryPos > 0)
-                            HistoryPos--;
+                        // Past the oldest command in memory, pull the next one in from the file
+                        if (HistoryPos == -1) {
+                            if (History.Newest() == -1)
+                                History.LoadOlder();
+                            HistoryPos = History.Newest();
+                        }
+                        else if (History.Older(HistoryPos) != -1 || History.LoadOlder()) {
+                            HistoryPos = History.Older(HistoryPos);
+                        }
                     }
                     else if (data->EventKey == ImGuiKey_DownArrow) {
                         if (HistoryPos != -1)
-                            if (++HistoryPos >= CommandHistory.Size)
-                                HistoryPos = -1;
+                            HistoryPos = History.Newer(HistoryPos);
                     }
                     
                     if (prev_history_pos != HistoryPos) {
-                        const char* history_str = (HistoryPos >= 0) ? CommandHistory[HistoryPos] : "";
+                        const char* history_str = (HistoryPos >= 0) ? History.Text(HistoryPos) : "";
                         data->DeleteChars(0, data->BufTextLen);
                         data->InsertChars(0, history_str);
                     }
@@ -118,16 +918,28 @@ namespace ClassGame {
             return 0;
         }
         
+        bool OpenHistory(const std::string& path) {
+            EndReverseSearch();
+            HistoryPos = -1;
+            return History.Open(path);
+        }
+        
+        void CloseHistory() {
+            EndReverseSearch();
+            HistoryPos = -1;
+            History.Close();
+        }
+        
         // Clear command history
         void ClearHistory() {
-            for (int i = 0; i < CommandHistory.Size; i++)
-                free(CommandHistory[i]);
-            CommandHistory.clear();
+            EndReverseSearch();
+            History.Clear();
+            HistoryPos = -1;
         }
         
         // Get command history
-        const ImVector<char*>& GetHistory() {
-            return CommandHistory;
+        const CommandHistory& GetHistory() {
+            return History;
         }
     }
 }
\ No newline at end of file
@@ -1,8 +1,96 @@
 #pragma once
 #include "imgui/imgui.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace ClassGame {
+    class CommandHistory;
+    
     namespace Command {
+        // One word of a command line. Every view points into the line itself; nothing is copied.
+        struct Token {
+            std::string_view raw;       // The whole token as typed, quotes included
+            std::string_view key;       // "key" of key=value, empty otherwise
+            std::string_view text;      // The value: the word, the quoted text, or what follows '='
+            bool quoted = false;
+        };
+        
+        // Split on spaces. "double quotes" keep spaces (no escapes) and key=value is split at
+        // the '='; the value may be quoted too. Returns the number of tokens, at most maxTokens;
+        // truncated is set when the line had more.
+        int Tokenize(std::string_view line, Token* tokens, int maxTokens, bool* truncated = nullptr);
+        
+        bool ParseInt(std::string_view text, int64_t& value);
+        bool ParseFloat(std::string_view text, double& value);
+        
+        enum class ArgType { String, Int, Float, Choice };
+        
+        // One parameter of a usage schema, see CommandSpec::usage
+        struct ArgParam {
+            std::string name;
+            ArgType type = ArgType::String;
+            std::string choices;        // Choice: "INFO|WARN|ERROR"
+            bool optional = false;
+            bool rest = false;          // "name..." takes the rest of the line
+        };
+        
+        // A command's arguments, bound to its usage schema before the handler runs. Values
+        // are views into the command line and are only valid during the call.
+        class Args {
+        public:
+            static constexpr int MaxTokens = 16;
+            static constexpr int MaxParams = 8;
+            
+            // Everything after the command name
+            std::string_view Raw() const { return raw; }
+            
+            bool Has(std::string_view name) const;
+            std::string_view Get(std::string_view name, std::string_view fallback = {}) const;
+            int64_t GetInt(std::string_view name, int64_t fallback = 0) const;
+            double GetFloat(std::string_view name, double fallback = 0.0) const;
+            
+            // Tokenize raw and bind it to params; on failure error says why
+            bool Bind(std::string_view raw, const std::vector<ArgParam>& params, char* error, size_t errorSize);
+            
+        private:
+            int Find(std::string_view name) const;
+            
+            std::string_view raw;
+            const std::vector<ArgParam>* params = nullptr;
+            std::string_view values[MaxParams];
+            bool bound[MaxParams] = {};
+            int64_t ints[MaxParams] = {};
+            double floats[MaxParams] = {};
+        };
+        
+        using Handler = std::function<void(const Args& args)>;
+        
+        // A console command. Names and aliases are matched case-insensitively.
+        //
+        // usage is the argument schema, shown by HELP and used to bind arguments:
+        //   <name> required, [name] optional, name:int / name:float / name:A|B|C typed (an int
+        //   must fit in an int), name... the rest of the line. Arguments can also be given as name=value.
+        // Positional words fill the required parameters first; leftover words fill the
+        // optional ones in order.
+        struct CommandSpec {
+            const char* name = nullptr;
+            const char* aliases = "";       // Space-separated other names, e.g. "CLS"
+            const char* usage = "";         // e.g. "[tag] [level:INFO|WARN|ERROR|OFF]", "" takes no arguments
+            const char* help = "";          // One line for HELP
+            Handler handler;
+        };
+        
+        // Add a command; false if its name or an alias is already taken or the usage schema
+        // doesn't parse. Lookup is a hash of the case-folded name, so dispatch cost doesn't
+        // grow with the number of commands.
+        bool RegisterCommand(const CommandSpec& spec);
+        
+        // HELP output: the command list, or one command's usage and description
+        void LogHelp(std::string_view command = {});
+        
         // String helper functions
         int Stricmp(const char* s1, const char* s2);
         int Strnicmp(const char* s1, const char* s2, int n);
@@ -12,11 +100,22 @@ namespace ClassGame {
         // Command execution
         void ExecCommand(const char* command_line);
         
-        // Input callback for history navigation
+        // Input callback for history navigation (Up/Down), completion of command names and of
+        // whole lines from history (Tab), and reverse history search (Ctrl+R). Needs the
+        // CallbackHistory, CallbackCompletion and CallbackAlways flags.
         int TextEditCallbackStub(ImGuiInputTextCallbackData* data);
         
-        // Command history management
+        // The command a running reverse search has found, "" for none, null when not searching
+        const char* ReverseSearchMatch();
+        // On Enter: replaces the line with the match, if a search is running, and ends it
+        void AcceptReverseSearch(char* buf, size_t size);
+        void EndReverseSearch();
+        
+        // Command history management. With a history file open, commands from earlier sessions
+        // come back as up-arrow reaches past this session's.
+        bool OpenHistory(const std::string& path);
+        void CloseHistory();
         void ClearHistory();
-        const ImVector<char*>& GetHistory();
+        const CommandHistory& GetHistory();
     }
 }
\ No newline at end of file
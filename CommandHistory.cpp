@@ -0,0 +1,304 @@
+#include "CommandHistory.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace ClassGame {
+
+// Raw file descriptor helpers, as in the file sinks
+static int OpenFile(const char* path, bool truncate) {
+#ifdef _WIN32
+    int fd = -1;
+    _sopen_s(&fd, path, _O_WRONLY | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : _O_APPEND), _SH_DENYNO,
+             _S_IREAD | _S_IWRITE);
+    return fd;
+#else
+    return open(path, O_WRONLY | O_CREAT | (truncate ? O_TRUNC : O_APPEND), 0644);
+#endif
+}
+
+static void WriteAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int written = _write(fd, data, (unsigned int)size);
+#else
+        ssize_t written = write(fd, data, size);
+#endif
+        if (written <= 0)
+            return;
+        data += written;
+        size -= (size_t)written;
+    }
+}
+
+static void CloseFd(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+// One command per line; a line break inside one would split it when read back
+static size_t FormatLine(std::string_view command, char* line) {
+    for (size_t i = 0; i < command.size(); i++)
+        line[i] = (command[i] == '\n' || command[i] == '\r') ? ' ' : command[i];
+    line[command.size()] = '\n';
+    return command.size() + 1;
+}
+
+// FNV-1a over the upper-cased text
+static uint32_t FoldedHash(std::string_view text) {
+    uint32_t hash = 2166136261u;
+    for (char c : text) {
+        hash ^= (uint32_t)toupper((unsigned char)c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool FoldedEqual(const char* stored, std::string_view text) {
+    for (size_t i = 0; i < text.size(); i++) {
+        if (toupper((unsigned char)stored[i]) != toupper((unsigned char)text[i]))
+            return false;
+    }
+    return stored[text.size()] == 0;
+}
+
+CommandHistory::CommandHistory(size_t capacity) {
+    SetCapacity(capacity);
+}
+
+void CommandHistory::SetCapacity(size_t newCapacity) {
+    capacity = newCapacity;
+    text.assign(capacity * MaxLength, 0);
+    slots.assign(capacity, Slot());
+    size_t indexSize = 16;
+    while (indexSize < capacity * 2)
+        indexSize <<= 1;
+    index.assign(indexSize, -1);
+    count = 0;
+    oldest = newest = -1;
+    unread = file.Size();
+}
+
+void CommandHistory::Clear() {
+    std::fill(index.begin(), index.end(), -1);
+    count = 0;
+    oldest = newest = -1;
+    if (fd >= 0) {
+        file.Close();
+        unread = fileSize = 0;
+        CloseFd(fd);
+        fd = OpenFile(path.c_str(), true);
+    }
+}
+
+bool CommandHistory::Open(const std::string& filePath) {
+    Close();
+    // A missing file just means no earlier sessions
+    if (!file.OpenRead(filePath))
+        file.Close();
+    fd = OpenFile(filePath.c_str(), false);
+    if (fd < 0) {
+        file.Close();
+        return false;
+    }
+    path = filePath;
+    unread = fileSize = file.Size();
+    return true;
+}
+
+void CommandHistory::Close() {
+    if (fd < 0)
+        return;
+
+    // Every command is appended, repeats included, so the file only grows. Once it holds more
+    // than a full history's worth of bytes, rewrite it with just the commands that would be
+    // kept, oldest first. The map and handle have to go before the rename for Windows' sake.
+    if (fileSize > capacity * MaxLength) {
+        while (LoadOlder()) {}
+        CloseFile();
+        std::string temp = path + ".tmp";
+        int out = OpenFile(temp.c_str(), true);
+        if (out >= 0) {
+            char line[MaxLength + 1];
+            for (int entry = oldest; entry >= 0; entry = slots[entry].newer) {
+                const char* command = Text(entry);
+                WriteAll(out, line, FormatLine(std::string_view(command, strlen(command)), line));
+            }
+            CloseFd(out);
+            std::error_code ec;
+            std::filesystem::rename(temp, path, ec);
+        }
+    }
+    CloseFile();
+    path.clear();
+}
+
+void CommandHistory::CloseFile() {
+    file.Close();
+    if (fd >= 0)
+        CloseFd(fd);
+    fd = -1;
+    unread = fileSize = 0;
+}
+
+// Walks the mapped file backwards a line at a time, so only as much of it is read as the
+// user scrolls back through
+bool CommandHistory::LoadOlder() {
+    const char* data = file.Data();
+    while (unread > 0 && count < capacity) {
+        size_t end = unread;
+        if (data[end - 1] == '\n')
+            end--;
+        size_t start = end;
+        while (start > 0 && data[start - 1] != '\n')
+            start--;
+        unread = start;
+
+        std::string_view command(data + start, end - start);
+        if (!command.empty() && command.back() == '\r')
+            command.remove_suffix(1);
+        if (command.size() >= MaxLength)
+            command = command.substr(0, MaxLength - 1);
+        // Anything already here was used more recently
+        if (command.empty() || Find(command) >= 0)
+            continue;
+
+        int entry = TakeSlot(FoldedHash(command));
+        SetText(entry, command);
+        LinkOldest(entry);
+        return true;
+    }
+    return false;
+}
+
+int CommandHistory::Find(std::string_view command) const {
+    if (command.size() >= MaxLength)
+        command = command.substr(0, MaxLength - 1);
+    uint32_t hash = FoldedHash(command);
+    size_t mask = index.size() - 1;
+    for (size_t i = hash & mask; index[i] >= 0; i = (i + 1) & mask) {
+        int entry = index[i];
+        if (slots[entry].hash == hash && FoldedEqual(Text(entry), command))
+            return entry;
+    }
+    return -1;
+}
+
+void CommandHistory::Add(std::string_view command) {
+    if (capacity == 0)
+        return;
+    if (command.size() >= MaxLength)
+        command = command.substr(0, MaxLength - 1);
+
+    if (fd >= 0) {
+        char line[MaxLength + 1];
+        size_t length = FormatLine(command, line);
+        WriteAll(fd, line, length);
+        fileSize += length;
+    }
+
+    // A repeat moves to the newest end; otherwise take a fresh slot or the oldest one
+    int entry = Find(command);
+    if (entry >= 0)
+        Unlink(entry);
+    else
+        entry = TakeSlot(FoldedHash(command));
+
+    // Keeps the casing it was last typed with
+    SetText(entry, command);
+    LinkNewest(entry);
+}
+
+int CommandHistory::TakeSlot(uint32_t hash) {
+    int entry;
+    if (count < capacity) {
+        entry = (int)count++;
+    }
+    else {
+        entry = oldest;
+        IndexRemove(entry);
+        Unlink(entry);
+    }
+    slots[entry].hash = hash;
+    IndexInsert(entry);
+    return entry;
+}
+
+void CommandHistory::SetText(int entry, std::string_view command) {
+    char* dst = &text[(size_t)entry * MaxLength];
+    memcpy(dst, command.data(), command.size());
+    dst[command.size()] = 0;
+}
+
+void CommandHistory::Unlink(int entry) {
+    Slot& slot = slots[entry];
+    if (slot.older >= 0)
+        slots[slot.older].newer = slot.newer;
+    else
+        oldest = slot.newer;
+    if (slot.newer >= 0)
+        slots[slot.newer].older = slot.older;
+    else
+        newest = slot.older;
+    slot.older = slot.newer = -1;
+}
+
+void CommandHistory::LinkNewest(int entry) {
+    slots[entry].older = newest;
+    slots[entry].newer = -1;
+    if (newest >= 0)
+        slots[newest].newer = entry;
+    else
+        oldest = entry;
+    newest = entry;
+}
+
+void CommandHistory::LinkOldest(int entry) {
+    slots[entry].newer = oldest;
+    slots[entry].older = -1;
+    if (oldest >= 0)
+        slots[oldest].older = entry;
+    else
+        newest = entry;
+    oldest = entry;
+}
+
+void CommandHistory::IndexInsert(int entry) {
+    size_t mask = index.size() - 1;
+    size_t i = slots[entry].hash & mask;
+    while (index[i] >= 0)
+        i = (i + 1) & mask;
+    index[i] = entry;
+}
+
+// Backward-shift deletion: later entries of the probe run move up into the hole, so the
+// table never needs tombstones
+void CommandHistory::IndexRemove(int entry) {
+    size_t mask = index.size() - 1;
+    size_t hole = slots[entry].hash & mask;
+    while (index[hole] != entry)
+        hole = (hole + 1) & mask;
+    for (size_t i = (hole + 1) & mask; index[i] >= 0; i = (i + 1) & mask) {
+        size_t home = slots[index[i]].hash & mask;
+        // Movable unless its home lies cyclically in (hole, i]
+        bool stays = hole < i ? (home > hole && home <= i) : (home > hole || home <= i);
+        if (!stays) {
+            index[hole] = index[i];
+            hole = i;
+        }
+    }
+    index[hole] = -1;
+}
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ClassGame {
+
+// Console command history with no duplicates (compared case-insensitively). Commands live in a
+// fixed pool of MaxLength-byte slots allocated once, linked oldest to newest; a case-folded
+// hash table maps a command to its slot. Adding a command that is already there relinks its
+// slot as the newest, and adding to a full history reuses the oldest slot, so Add is O(1) and
+// never allocates however many commands are kept.
+//
+// Entries are addressed by slot handles that stay valid until the entry is evicted or cleared;
+// -1 means none.
+//
+// With a file open, every command is also appended to it as a line, so history carries over
+// between sessions. Opening only maps the file: earlier sessions' commands are read backwards
+// from the end, one at a time, as navigation reaches the oldest entry in memory (LoadOlder).
+class CommandHistory {
+public:
+    static constexpr size_t MaxLength = 256;       // Including the terminator; longer commands are cut
+
+    explicit CommandHistory(size_t capacity = 1000);
+    ~CommandHistory() { Close(); }
+    CommandHistory(const CommandHistory&) = delete;
+    CommandHistory& operator=(const CommandHistory&) = delete;
+
+    bool Open(const std::string& path);
+    // Rewrites the file with just the commands kept once it has grown well past that, then closes it
+    void Close();
+    bool IsOpen() const { return fd >= 0; }
+
+    // Read the next older command from the file that isn't already in memory into the oldest
+    // end. False once the file is used up or the history is full.
+    bool LoadOlder();
+
+    // Drops the current contents
+    void SetCapacity(size_t capacity);
+    size_t Capacity() const { return capacity; }
+    size_t Size() const { return count; }
+
+    void Add(std::string_view command);
+    // Also empties the file
+    void Clear();
+
+    // Case-insensitive exact match
+    int Find(std::string_view command) const;
+
+    int Newest() const { return newest; }
+    int Oldest() const { return oldest; }
+    int Older(int entry) const { return slots[entry].older; }
+    int Newer(int entry) const { return slots[entry].newer; }
+    const char* Text(int entry) const { return &text[(size_t)entry * MaxLength]; }
+
+private:
+    struct Slot {
+        uint32_t hash = 0;
+        int older = -1;
+        int newer = -1;
+    };
+
+    int TakeSlot(uint32_t hash);
+    void SetText(int entry, std::string_view command);
+    void Unlink(int entry);
+    void LinkNewest(int entry);
+    void LinkOldest(int entry);
+    void CloseFile();
+    void IndexInsert(int entry);
+    void IndexRemove(int entry);
+
+    size_t capacity = 0;
+    size_t count = 0;
+    std::vector<char> text;             // capacity * MaxLength, slot i at i * MaxLength
+    std::vector<Slot> slots;
+    std::vector<int> index;             // Open addressing over slot handles, -1 empty, at most half full
+    int oldest = -1;
+    int newest = -1;
+
+    std::string path;
+    int fd = -1;                        // Append handle
+    MappedFile file;                    // The file as it was when opened
+    size_t unread = 0;                  // file bytes before this haven't been loaded yet
+    size_t fileSize = 0;                // Including what this session appended
+};
+
+}
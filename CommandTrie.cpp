@@ -0,0 +1,90 @@
+#include "CommandTrie.h"
+#include <cctype>
+
+namespace ClassGame {
+
+static char Fold(char c) {
+    return (char)toupper((unsigned char)c);
+}
+
+void CommandTrie::Insert(std::string_view key, uint32_t value) {
+    uint32_t node = 0;
+    for (char c : key) {
+        c = Fold(c);
+        // Find the child for c, or link a new one in where it sorts
+        uint32_t previous = 0;
+        uint32_t child = nodes[node].child;
+        while (child != 0 && (unsigned char)nodes[child].c < (unsigned char)c) {
+            previous = child;
+            child = nodes[child].sibling;
+        }
+        if (child == 0 || nodes[child].c != c) {
+            uint32_t added = (uint32_t)nodes.size();
+            nodes.push_back(Node());
+            nodes[added].c = c;
+            nodes[added].sibling = child;
+            if (previous != 0)
+                nodes[previous].sibling = added;
+            else
+                nodes[node].child = added;
+            child = added;
+        }
+        node = child;
+    }
+    if (nodes[node].value < 0)
+        nodes[node].value = value;
+}
+
+void CommandTrie::Clear() {
+    nodes.assign(1, Node());
+}
+
+uint32_t CommandTrie::FindNode(std::string_view prefix) const {
+    uint32_t node = 0;
+    for (char c : prefix) {
+        c = Fold(c);
+        uint32_t child = nodes[node].child;
+        while (child != 0 && nodes[child].c != c)
+            child = nodes[child].sibling;
+        if (child == 0)
+            return UINT32_MAX;
+        node = child;
+    }
+    return node;
+}
+
+size_t CommandTrie::Collect(std::string_view prefix, std::vector<uint32_t>& values, size_t max) const {
+    values.clear();
+    uint32_t start = FindNode(prefix);
+    if (start == UINT32_MAX)
+        return 0;
+
+    // Depth first, children in order; siblings of the start node aren't part of the subtree
+    std::vector<uint32_t> stack{ start };
+    while (!stack.empty() && values.size() < max) {
+        uint32_t node = stack.back();
+        stack.pop_back();
+        if (nodes[node].value >= 0)
+            values.push_back((uint32_t)nodes[node].value);
+        if (node != start && nodes[node].sibling != 0)
+            stack.push_back(nodes[node].sibling);
+        if (nodes[node].child != 0)
+            stack.push_back(nodes[node].child);
+    }
+    return values.size();
+}
+
+size_t CommandTrie::CommonPrefix(std::string_view prefix) const {
+    uint32_t node = FindNode(prefix);
+    if (node == UINT32_MAX)
+        return 0;
+    size_t length = prefix.size();
+    // Follow single children until a key ends or the names branch
+    while (nodes[node].value < 0 && nodes[node].child != 0 && nodes[nodes[node].child].sibling == 0) {
+        node = nodes[node].child;
+        length++;
+    }
+    return length;
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace ClassGame {
+
+// Case-insensitive prefix tree over console command names, for tab completion. Each node is one
+// upper-cased character with its children kept in order, so a prefix is found in one step per
+// character and everything below it comes out alphabetically.
+class CommandTrie {
+public:
+    void Insert(std::string_view key, uint32_t value);
+    void Clear();
+
+    // Values of the keys starting with prefix, alphabetically, at most max of them
+    size_t Collect(std::string_view prefix, std::vector<uint32_t>& values, size_t max) const;
+
+    // How far every key starting with prefix agrees, at least prefix.size(); 0 if none start with it
+    size_t CommonPrefix(std::string_view prefix) const;
+
+private:
+    struct Node {
+        uint32_t child = 0;             // First child, 0 none (the root is never a child)
+        uint32_t sibling = 0;           // Next child of the same parent, in character order
+        int64_t value = -1;             // Set where a key ends
+        char c = 0;
+    };
+
+    uint32_t FindNode(std::string_view prefix) const;
+
+    std::vector<Node> nodes = std::vector<Node>(1);
+};
+
+}
@@ -0,0 +1,107 @@
+#include "LogArchiver.h"
+#include "LogCompress.h"
+#include <filesystem>
+
+namespace ClassGame {
+
+void LogArchiver::Start() {
+    if (worker.joinable())
+        return;
+    stopping = false;
+    worker = std::thread(&LogArchiver::Run, this);
+}
+
+void LogArchiver::Stop() {
+    if (!worker.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void LogArchiver::Enqueue(const std::string& path) {
+    Push({ path, false });
+}
+
+void LogArchiver::EnqueueRemove(const std::string& path) {
+    Push({ path, true });
+}
+
+void LogArchiver::Push(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+size_t LogArchiver::Archived() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return archived;
+}
+
+size_t LogArchiver::BytesIn() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytesIn;
+}
+
+size_t LogArchiver::BytesOut() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytesOut;
+}
+
+void LogArchiver::Run() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty())
+                return;
+            job = std::move(pending.front());
+            pending.pop_front();
+        }
+
+        if (job.remove) {
+            std::error_code error;
+            std::filesystem::remove(job.path, error);
+            std::filesystem::remove(job.path + LogCompress::Extension, error);
+            std::filesystem::remove(job.path + LogCompress::PartialExtension, error);
+        }
+        else {
+            Compress(job.path);
+        }
+    }
+}
+
+// Written under a temporary name so a reader never sees half an archive, and the original is
+// only removed once the archive is complete
+void LogArchiver::Compress(const std::string& path) {
+    std::string archivePath = path + LogCompress::Extension;
+    std::string partialPath = path + LogCompress::PartialExtension;
+    std::error_code error;
+    uintmax_t rawSize = std::filesystem::file_size(path, error);
+    if (error || !LogCompress::CompressFile(path, partialPath)) {
+        std::filesystem::remove(partialPath, error);
+        return;     // Unreadable: leave it be
+    }
+    std::filesystem::rename(partialPath, archivePath, error);
+    if (error) {
+        std::filesystem::remove(partialPath, error);
+        return;
+    }
+    uintmax_t archiveSize = std::filesystem::file_size(archivePath, error);
+    if (error)
+        archiveSize = 0;
+    std::filesystem::remove(path, error);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    archived++;
+    bytesIn += (size_t)rawSize;
+    bytesOut += (size_t)archiveSize;
+}
+
+}
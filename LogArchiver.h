@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace ClassGame {
+
+// Background thread that compresses finished log segments (LogCompress) and deletes the
+// originals, so the game loop and the log writer never pay for it. Fed by
+// RotatingFileSink::onSegmentClosed, and by onSegmentExpired so retention deletes a segment
+// only after any compression queued before it has finished.
+class LogArchiver {
+public:
+    LogArchiver() = default;
+    ~LogArchiver() { Stop(); }
+    LogArchiver(const LogArchiver&) = delete;
+    LogArchiver& operator=(const LogArchiver&) = delete;
+
+    void Start();
+    // Finish the files already queued, then join the thread
+    void Stop();
+    bool IsRunning() const { return worker.joinable(); }
+
+    // Any thread. path becomes path + LogCompress::Extension once compressed.
+    void Enqueue(const std::string& path);
+    // Any thread. Deletes path and its archive, in order with the compressions queued before it.
+    void EnqueueRemove(const std::string& path);
+
+    size_t Archived() const;
+    size_t BytesIn() const;
+    size_t BytesOut() const;
+
+private:
+    struct Job {
+        std::string path;
+        bool remove;
+    };
+    void Run();
+    void Push(Job job);
+    void Compress(const std::string& path);
+
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Job> pending;
+    bool stopping = false;
+    size_t archived = 0;
+    size_t bytesIn = 0;
+    size_t bytesOut = 0;
+};
+
+}
@@ -0,0 +1,117 @@
+#include "LogArena.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace ClassGame {
+
+LogArena::~LogArena() {
+    for (size_t i = chunkHead; i < chunks.size(); i++) {
+        if (chunks[i].span > 0)
+            free(chunks[i].data);
+    }
+    for (char* chunk : freeChunks)
+        free(chunk);
+}
+
+void LogArena::SetChunkSize(size_t size) {
+    if (size < MinChunkSize)
+        size = MinChunkSize;
+    if (size == chunkSize || ChunksInUse() > 0)
+        return;
+    for (char* chunk : freeChunks)
+        free(chunk);
+    freeChunks.clear();
+    // Start the next append on a boundary of the new size so positions keep increasing
+    chunkSize = size;
+    writePos = releasedPos = (writePos + size - 1) / size * size;
+    firstChunk = writePos / size;
+}
+
+char* LogArena::NewChunk() {
+    if (!freeChunks.empty()) {
+        char* chunk = freeChunks.back();
+        freeChunks.pop_back();
+        return chunk;
+    }
+    allocations++;
+    return (char*)malloc(chunkSize);
+}
+
+uint64_t LogArena::Append(std::string_view text) {
+    if (text.empty())
+        return writePos;
+    memcpy(Reserve(text.size()), text.data(), text.size());
+    return Commit(text.size());
+}
+
+char* LogArena::Reserve(size_t len) {
+    // Skip the tail of the current chunk if the message doesn't fit in it
+    size_t offset = (size_t)(writePos % chunkSize);
+    if (offset != 0 && offset + len > chunkSize)
+        writePos += chunkSize - offset;
+
+    // Make sure the chunk(s) under writePos exist
+    uint64_t endChunk = firstChunk + (chunks.size() - chunkHead);
+    if (writePos / chunkSize >= endChunk) {
+        // Drop released slots from the front before growing; keeps the vector's capacity
+        if (chunkHead > 0 && chunkHead >= chunks.size() / 2) {
+            chunks.erase(chunks.begin(), chunks.begin() + chunkHead);
+            chunkHead = 0;
+        }
+        if (chunks.size() == chunkHead)
+            firstChunk = writePos / chunkSize;
+
+        if (len <= chunkSize) {
+            chunks.push_back({ NewChunk(), 1 });
+        }
+        else {
+            // Oversized message: one contiguous block spanning several chunk indices
+            uint32_t span = (uint32_t)((len + chunkSize - 1) / chunkSize);
+            allocations++;
+            char* block = (char*)malloc((size_t)span * chunkSize);
+            chunks.push_back({ block, span });
+            for (uint32_t i = 1; i < span; i++)
+                chunks.push_back({ block + (size_t)i * chunkSize, 0 });
+        }
+    }
+    return (char*)Get(writePos);
+}
+
+uint64_t LogArena::Commit(size_t len) {
+    uint64_t pos = writePos;
+    writePos += len;
+    return pos;
+}
+
+size_t LogArena::TailSpace() const {
+    uint64_t endChunk = firstChunk + (chunks.size() - chunkHead);
+    if (writePos / chunkSize >= endChunk)
+        return 0;
+    return chunkSize - (size_t)(writePos % chunkSize);
+}
+
+const char* LogArena::Get(uint64_t pos) const {
+    const Chunk& chunk = chunks[chunkHead + (size_t)(pos / chunkSize - firstChunk)];
+    return chunk.data + pos % chunkSize;
+}
+
+void LogArena::ReleaseBefore(uint64_t pos) {
+    if (pos <= releasedPos)
+        return;
+    releasedPos = pos;
+
+    // Recycle every allocation that ends at or before pos
+    while (chunkHead < chunks.size()) {
+        const Chunk& chunk = chunks[chunkHead];
+        if ((firstChunk + chunk.span) * chunkSize > pos)
+            break;
+        if (chunk.span == 1)
+            freeChunks.push_back(chunk.data);
+        else
+            free(chunk.data);
+        firstChunk += chunk.span;
+        chunkHead += chunk.span;
+    }
+}
+
+}
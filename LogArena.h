@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace ClassGame {
+
+// Chunked, append-only text storage for log messages (same idea as ImGuiTextBuffer, but
+// the front can be released). Text is written into fixed-size chunks; once every message in
+// a chunk has been evicted the chunk goes back to a free list and is reused, so after warm-up
+// appending never touches the heap.
+// Positions are absolute byte offsets that only increase, entries store them as plain integers.
+class LogArena {
+public:
+    static constexpr size_t MinChunkSize = 1024;
+
+    explicit LogArena(size_t chunkSize = 64 * 1024) : chunkSize(chunkSize < MinChunkSize ? MinChunkSize : chunkSize) {}
+    ~LogArena();
+    LogArena(const LogArena&) = delete;
+    LogArena& operator=(const LogArena&) = delete;
+
+    // Only valid while the arena is empty. Sizes below MinChunkSize are raised to it.
+    void SetChunkSize(size_t size);
+
+    // Copy text in and return its position. A message never straddles two chunks.
+    uint64_t Append(std::string_view text);
+
+    // Two-step append for writing in place (e.g. vsnprintf straight into the arena):
+    // Reserve guarantees len contiguous bytes at the write position, Commit keeps the first len.
+    char* Reserve(size_t len);
+    uint64_t Commit(size_t len);
+
+    // Bytes left in the current chunk and where they start, usable without Reserve
+    size_t TailSpace() const;
+    char* Tail() { return (char*)Get(writePos); }
+
+    // Text previously returned by Append; valid until released
+    const char* Get(uint64_t pos) const;
+
+    // Nothing before pos is referenced anymore, chunks wholly before it are recycled
+    void ReleaseBefore(uint64_t pos);
+    void Clear() { ReleaseBefore(writePos); }
+
+    size_t BytesInUse() const { return (size_t)(writePos - releasedPos); }
+    size_t ChunksInUse() const { return chunks.size() - chunkHead; }
+    size_t Allocations() const { return allocations; }
+
+private:
+    struct Chunk {
+        char* data;
+        uint32_t span;      // Chunk indices covered by this allocation (0 = continuation of an oversized block)
+    };
+
+    char* NewChunk();
+
+    size_t chunkSize;
+    std::vector<Chunk> chunks;      // Live chunks, chunks[chunkHead] holds chunk index firstChunk
+    size_t chunkHead = 0;
+    uint64_t firstChunk = 0;
+    std::vector<char*> freeChunks;
+    uint64_t writePos = 0;
+    uint64_t releasedPos = 0;
+    size_t allocations = 0;
+};
+
+}
@@ -0,0 +1,420 @@
+#include "LogBinary.h"
+#include <cstdarg>
+#include <cstdio>
+
+namespace ClassGame {
+namespace LogBinary {
+
+size_t WriteVarint(char* out, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (char)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (char)value;
+    return n;
+}
+
+const char* ReadVarint(const char* p, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = (uint8_t)*p++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return p;
+    }
+    return nullptr;
+}
+
+static void WriteFixed64(char* out, uint64_t value) {
+    for (int i = 0; i < 8; i++)
+        out[i] = (char)(value >> (i * 8));
+}
+
+static uint64_t ReadFixed64(const char* p) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++)
+        value |= (uint64_t)(uint8_t)p[i] << (i * 8);
+    return value;
+}
+
+// Steps to the next conversion: skips literal text and "%%", notes how many '*' arguments come
+// before its value and any literal precision. The length modifier and conversion character are
+// left for the next search to skip.
+bool ArgWriter::NextConversion() {
+    for (;;) {
+        const char* percent = strchr(format, '%');
+        if (!percent) {
+            format = nullptr;
+            return false;
+        }
+        format = percent + 1;
+        if (*format != '%')
+            break;
+        format++;
+    }
+    starsLeft = 0;
+    starPrecision = false;
+    precision = -1;
+    while (*format && strchr("-+ #0", *format))
+        format++;
+    if (*format == '*') {
+        starsLeft++;
+        format++;
+    }
+    while (*format >= '0' && *format <= '9')
+        format++;
+    if (*format == '.') {
+        format++;
+        if (*format == '*') {
+            starsLeft++;
+            starPrecision = true;
+            format++;
+        }
+        else {
+            precision = 0;
+            while (*format >= '0' && *format <= '9')
+                precision = precision * 10 + (*format++ - '0');
+        }
+    }
+    valuePending = true;
+    return true;
+}
+
+ArgWriter::Slot ArgWriter::NextSlot() {
+    if (!valuePending && (!format || !NextConversion()))
+        return Slot::Value;
+    if (starsLeft > 0) {
+        starsLeft--;
+        return starsLeft == 0 && starPrecision ? Slot::Precision : Slot::Width;
+    }
+    valuePending = false;
+    return Slot::Value;
+}
+
+void ArgWriter::Int(int64_t value) {
+    if (NextSlot() == Slot::Precision)
+        precision = value < 0 ? -1 : value;    // Negative means "none", as in printf
+    if (!Reserve(1 + MaxVarintSize))
+        return;
+    out[used++] = (char)ArgInt;
+    used += WriteVarint(out + used, ZigZag(value));
+}
+
+void ArgWriter::Unsigned(uint64_t value) {
+    if (NextSlot() == Slot::Precision)
+        precision = value > INT32_MAX ? -1 : (int64_t)value;
+    if (!Reserve(1 + MaxVarintSize))
+        return;
+    out[used++] = (char)ArgUnsigned;
+    used += WriteVarint(out + used, value);
+}
+
+void ArgWriter::Double(double value) {
+    NextSlot();
+    if (!Reserve(9))
+        return;
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    out[used++] = (char)ArgDouble;
+    WriteFixed64(out + used, bits);
+    used += 8;
+}
+
+void ArgWriter::String(const char* value) {
+    NextSlot();
+    if (!value)
+        value = "(null)";
+    size_t length;
+    if (precision >= 0) {
+        // printf reads no further than the precision, the text needn't be terminated
+        const void* nul = memchr(value, 0, (size_t)precision);
+        length = nul ? (size_t)((const char*)nul - value) : (size_t)precision;
+    }
+    else {
+        length = strlen(value);
+    }
+    if (!Reserve(1 + MaxVarintSize + length))
+        return;
+    out[used++] = (char)ArgString;
+    used += WriteVarint(out + used, length);
+    memcpy(out + used, value, length);
+    used += length;
+}
+
+void ArgWriter::Pointer(const void* value) {
+    NextSlot();
+    if (!Reserve(9))
+        return;
+    out[used++] = (char)ArgPointer;
+    WriteFixed64(out + used, (uint64_t)(uintptr_t)value);
+    used += 8;
+}
+
+// One decoded argument
+struct DecodedArg {
+    uint8_t type = 0;
+    uint64_t bits = 0;
+    std::string_view text;
+};
+
+static bool ReadArg(const char*& p, const char* end, DecodedArg& arg) {
+    if (p >= end)
+        return false;
+    arg.type = (uint8_t)*p++;
+    switch (arg.type) {
+        case ArgInt:
+        case ArgUnsigned:
+            p = ReadVarint(p, end, arg.bits);
+            return p != nullptr;
+        case ArgDouble:
+        case ArgPointer:
+            if (end - p < 8)
+                return false;
+            arg.bits = ReadFixed64(p);
+            p += 8;
+            return true;
+        case ArgString: {
+            uint64_t length;
+            p = ReadVarint(p, end, length);
+            if (!p || length > (uint64_t)(end - p))
+                return false;
+            arg.text = std::string_view(p, (size_t)length);
+            p += length;
+            return true;
+        }
+    }
+    return false;
+}
+
+static double AsDouble(const DecodedArg& arg) {
+    double value;
+    memcpy(&value, &arg.bits, sizeof(value));
+    return value;
+}
+
+static long long AsInt(const DecodedArg& arg) {
+    if (arg.type == ArgInt) return (long long)UnZigZag(arg.bits);
+    if (arg.type == ArgDouble) return (long long)AsDouble(arg);
+    return (long long)arg.bits;
+}
+
+static void AppendFormatted(std::string& out, const char* spec, ...) {
+    char local[256];
+    va_list args, retry;
+    va_start(args, spec);
+    va_copy(retry, args);
+    int length = vsnprintf(local, sizeof(local), spec, args);
+    if (length > 0 && (size_t)length < sizeof(local)) {
+        out.append(local, (size_t)length);
+    }
+    else if (length > 0) {
+        size_t start = out.size();
+        out.resize(start + (size_t)length + 1);
+        vsnprintf(&out[start], (size_t)length + 1, spec, retry);
+        out.resize(start + (size_t)length);
+    }
+    va_end(retry);
+    va_end(args);
+}
+
+bool FormatArgs(std::string& out, const char* format, const char* args, size_t length) {
+    const char* p = args;
+    const char* end = args + length;
+    bool ok = true;
+    out.clear();
+
+    const char* f = format;
+    while (*f) {
+        const char* percent = strchr(f, '%');
+        if (!percent) {
+            out.append(f);
+            break;
+        }
+        out.append(f, (size_t)(percent - f));
+        f = percent + 1;
+        if (*f == '%') {
+            out += '%';
+            f++;
+            continue;
+        }
+
+        // Rebuild the conversion spec: flags, width and precision are kept, '*' is replaced
+        // by its argument, and the length modifier is dropped since the encoded type decides it
+        char spec[48];
+        size_t n = 0;
+        spec[n++] = '%';
+        while (*f && strchr("-+ #0", *f) && n < 8)
+            spec[n++] = *f++;
+        for (int part = 0; part < 2; part++) {
+            if (part == 1) {
+                if (*f != '.')
+                    break;
+                f++;
+            }
+            int value = 0;
+            bool given = false;
+            if (*f == '*') {
+                DecodedArg star;
+                if (!ReadArg(p, end, star))
+                    ok = false;
+                value = (int)AsInt(star);
+                given = part == 0 || value >= 0;   // Negative precision means "none"
+                f++;
+            }
+            else {
+                given = part == 1 || (*f >= '0' && *f <= '9');
+                while (*f >= '0' && *f <= '9')
+                    value = value * 10 + (*f++ - '0');
+            }
+            if (given)
+                n += snprintf(spec + n, 12, part == 0 ? "%d" : ".%d", value);
+        }
+        while (*f && strchr("hljztLq", *f))
+            f++;
+        char conversion = *f;
+        if (!conversion)
+            break;
+        f++;
+        if (conversion == 'n')
+            continue;
+
+        DecodedArg arg;
+        if (!ReadArg(p, end, arg)) {
+            out += "<?>";
+            ok = false;
+            continue;
+        }
+        switch (conversion) {
+            case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+                if (arg.type == ArgString) {
+                    ok = false;
+                    out += "<?>";
+                    break;
+                }
+                spec[n++] = 'l';
+                spec[n++] = 'l';
+                spec[n++] = conversion;
+                spec[n] = '\0';
+                AppendFormatted(out, spec, AsInt(arg));
+                break;
+            case 'c':
+                spec[n++] = 'c';
+                spec[n] = '\0';
+                AppendFormatted(out, spec, (int)AsInt(arg));
+                break;
+            case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+                spec[n++] = conversion;
+                spec[n] = '\0';
+                AppendFormatted(out, spec, arg.type == ArgDouble ? AsDouble(arg) : (double)AsInt(arg));
+                ok = ok && arg.type == ArgDouble;
+                break;
+            case 's':
+                if (arg.type != ArgString) {
+                    ok = false;
+                    out += "<?>";
+                    break;
+                }
+                // Args aren't NUL terminated; %.*s bounds the read, an explicit precision still applies
+                if (strchr(spec, '.')) {
+                    std::string text(arg.text);
+                    spec[n++] = 's';
+                    spec[n] = '\0';
+                    AppendFormatted(out, spec, text.c_str());
+                }
+                else {
+                    memcpy(spec + n, ".*s", 4);
+                    AppendFormatted(out, spec, (int)arg.text.size(), arg.text.data());
+                }
+                break;
+            case 'p':
+                spec[n++] = 'p';
+                spec[n] = '\0';
+                AppendFormatted(out, spec, (void*)(uintptr_t)arg.bits);
+                break;
+            default:
+                ok = false;
+                out += "<?>";
+                break;
+        }
+    }
+    return ok && p == end;
+}
+
+bool Reader::Open(const std::string& path) {
+    if (!file.OpenRead(path))
+        return false;
+    pos = file.Data();
+    end = pos + file.Size();
+    truncated = false;
+    sessions = 0;
+    return true;
+}
+
+bool Reader::ReadString(std::string& out) {
+    uint64_t length;
+    pos = ReadVarint(pos, end, length);
+    if (!pos || length > (uint64_t)(end - pos))
+        return false;
+    out.assign(pos, (size_t)length);
+    pos += length;
+    return true;
+}
+
+bool Reader::Next(Entry& entry) {
+    while (pos && pos < end) {
+        if ((size_t)(end - pos) >= SessionSize && memcmp(pos, Magic, sizeof(Magic)) == 0) {
+            lastTimeMs = (int64_t)ReadFixed64(pos + sizeof(Magic));
+            tags.assign(1, std::string());
+            formats.assign(1, std::string("%s"));
+            sessions++;
+            pos += SessionSize;
+            continue;
+        }
+        if (sessions == 0)
+            break;
+
+        uint8_t type = (uint8_t)*pos++;
+        uint64_t id;
+        if (type == RecordTag || type == RecordFormat) {
+            std::vector<std::string>& table = type == RecordTag ? tags : formats;
+            pos = ReadVarint(pos, end, id);
+            if (!pos || id > 0xffff)
+                break;
+            if (table.size() <= id)
+                table.resize((size_t)id + 1);
+            if (!ReadString(table[(size_t)id]))
+                break;
+            continue;
+        }
+        if (type != RecordEntry)
+            break;
+
+        uint64_t delta, tagId, formatId, length;
+        pos = ReadVarint(pos, end, delta);
+        if (!pos || pos >= end)
+            break;
+        uint8_t level = (uint8_t)*pos++;
+        pos = ReadVarint(pos, end, tagId);
+        if (pos) pos = ReadVarint(pos, end, formatId);
+        if (pos) pos = ReadVarint(pos, end, length);
+        if (!pos || length > (uint64_t)(end - pos) || level >= (uint8_t)LogLevel::Count ||
+            tagId >= tags.size() || formatId >= formats.size())
+            break;
+
+        lastTimeMs += UnZigZag(delta);
+        entry.timeMs = lastTimeMs;
+        entry.level = (LogLevel)level;
+        entry.tag = tags[(size_t)tagId];
+        FormatArgs(entry.message, formats[(size_t)formatId].c_str(), pos, (size_t)length);
+        pos += length;
+        return true;
+    }
+    // Anything left over is a record cut short by a crash or a damaged file
+    truncated = pos != end;
+    pos = end;
+    return false;
+}
+
+}
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "LogRecord.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace ClassGame {
+
+// Compact binary form of the log (game_log.bin). A file is one or more sessions:
+//
+//   session  "GLOGBIN1" + int64 base time (ms since epoch, little endian)
+//   tag      0x01 varint id, varint length, bytes
+//   format   0x02 varint id, varint length, bytes     (printf format string)
+//   entry    0x03 varint zigzag(time - previous time), level byte, varint tag id,
+//                 varint format id, varint args length, args
+//
+// Tag and format ids are only valid inside their session and are defined before first use.
+// Tag id 0 is "no tag"; format id 0 is a pre-formatted message carried as a single string arg.
+// Args are a sequence of a type byte followed by its payload, in printf argument order.
+namespace LogBinary {
+
+constexpr char Magic[8] = { 'G', 'L', 'O', 'G', 'B', 'I', 'N', '1' };
+constexpr size_t SessionSize = sizeof(Magic) + 8;
+
+enum RecordType : uint8_t {
+    RecordTag = 0x01,
+    RecordFormat = 0x02,
+    RecordEntry = 0x03,
+};
+
+enum ArgType : uint8_t {
+    ArgInt = 'i',           // zigzag varint
+    ArgUnsigned = 'u',      // varint
+    ArgDouble = 'd',        // 8 bytes, IEEE little endian
+    ArgString = 's',        // varint length, bytes
+    ArgPointer = 'p',       // 8 bytes
+};
+
+constexpr size_t MaxVarintSize = 10;
+constexpr size_t EncodeFailed = (size_t)-1;
+
+inline uint64_t ZigZag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+inline int64_t UnZigZag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+// out needs MaxVarintSize bytes, returns the bytes written
+size_t WriteVarint(char* out, uint64_t value);
+// Returns the byte after the varint, or nullptr if it runs past end
+const char* ReadVarint(const char* p, const char* end, uint64_t& value);
+
+// Serializes printf arguments into a fixed buffer without formatting them. Given the format,
+// it follows the conversions along with the arguments so a string with a precision ("%.*s",
+// "%.8s") is copied up to that many bytes and may be unterminated, as printf allows.
+class ArgWriter {
+public:
+    ArgWriter(char* out, size_t capacity, const char* format = nullptr)
+        : out(out), capacity(capacity), format(format) {}
+
+    void Int(int64_t value);
+    void Unsigned(uint64_t value);
+    void Double(double value);
+    void String(const char* value);
+    void Pointer(const void* value);
+
+    // EncodeFailed when the arguments did not fit
+    size_t Length() const { return failed ? EncodeFailed : used; }
+
+private:
+    bool Reserve(size_t size) {
+        failed = failed || used + size > capacity;
+        return !failed;
+    }
+    // What the next argument is for: a '*' width, a '*' precision, or a conversion's value
+    enum class Slot { Width, Precision, Value };
+    Slot NextSlot();
+    bool NextConversion();
+
+    char* out;
+    size_t capacity;
+    size_t used = 0;
+    bool failed = false;
+    const char* format;         // Past the conversions seen so far, nullptr when there are no more
+    int starsLeft = 0;          // '*' arguments the current conversion still takes
+    bool starPrecision = false; // The last of them is the precision
+    bool valuePending = false;  // The current conversion's own argument hasn't come yet
+    int64_t precision = -1;     // Of the current conversion, -1 = none
+};
+
+template<typename T>
+void EncodeArg(ArgWriter& writer, const T& value) {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, char*> || std::is_same_v<D, const char*>)
+        writer.String(value);
+    else if constexpr (std::is_pointer_v<D> || std::is_null_pointer_v<D>)
+        writer.Pointer((const void*)value);
+    else if constexpr (std::is_floating_point_v<D>)
+        writer.Double((double)value);
+    else if constexpr (std::is_enum_v<D>)
+        EncodeArg(writer, (std::underlying_type_t<D>)value);
+    else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>)
+        writer.Int((int64_t)value);
+    else if constexpr (std::is_integral_v<D>)
+        writer.Unsigned((uint64_t)value);
+    else
+        static_assert(std::is_integral_v<D>, "unsupported printf argument type");
+}
+
+// Returns the encoded length, or EncodeFailed if it exceeds capacity. format is the printf
+// format the args belong to, or nullptr to treat every string as NUL terminated.
+template<typename... Args>
+size_t EncodeArgs(char* out, size_t capacity, const char* format, const Args&... args) {
+    ArgWriter writer(out, capacity, format);
+    (EncodeArg(writer, args), ...);
+    return writer.Length();
+}
+
+// Expand a format string against encoded args, one printf conversion at a time.
+// Returns false (with a best-effort result) if the args don't match the format.
+bool FormatArgs(std::string& out, const char* format, const char* args, size_t length);
+
+// Sequential reader over a .bin log
+class Reader {
+public:
+    struct Entry {
+        int64_t timeMs = 0;
+        LogLevel level = LogLevel::Info;
+        std::string_view tag;
+        std::string message;
+    };
+
+    bool Open(const std::string& path);
+
+    // False at the end of the file or on a damaged/truncated record (see Truncated())
+    bool Next(Entry& entry);
+    bool Truncated() const { return truncated; }
+    size_t Sessions() const { return sessions; }
+
+private:
+    bool ReadString(std::string& out);
+
+    MappedFile file;
+    const char* pos = nullptr;
+    const char* end = nullptr;
+    int64_t lastTimeMs = 0;
+    std::vector<std::string> tags;
+    std::vector<std::string> formats;
+    bool truncated = false;
+    size_t sessions = 0;
+};
+
+}
+
+}
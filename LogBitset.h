@@ -0,0 +1,35 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ClassGame {
+
+// Fixed-size bit array in the spirit of ImBitVector, stored as 64-bit words so several sets
+// can be combined a word at a time.
+class LogBitset {
+public:
+    void Resize(size_t bits) { words.assign((bits + 63) / 64, 0); }
+    void ClearAll() { words.assign(words.size(), 0); }
+
+    void SetBit(size_t i) { words[i >> 6] |= (uint64_t)1 << (i & 63); }
+    void ClearBit(size_t i) { words[i >> 6] &= ~((uint64_t)1 << (i & 63)); }
+    bool TestBit(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+
+    size_t WordCount() const { return words.size(); }
+    uint64_t Word(size_t w) const { return words[w]; }
+
+    // Bit index of the nth (0-based) set bit of word; word must have more than n bits set
+    static int SelectInWord(uint64_t word, int n) {
+        for (; n > 0; n--)
+            word &= word - 1;
+        return std::countr_zero(word);
+    }
+
+private:
+    std::vector<uint64_t> words;
+};
+
+}
@@ -0,0 +1,254 @@
+#include "LogCompress.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ClassGame {
+namespace LogCompress {
+
+static constexpr size_t MinMatch = 4;
+static constexpr size_t LastLiterals = 5;      // The format ends every block with literals
+static constexpr size_t MatchLimit = 12;       // No match may start in the last 12 bytes
+static constexpr size_t MaxOffset = 65535;
+static constexpr int HashBits = 12;
+static constexpr size_t MaxRawBlock = 16 * BlockSize;  // Rejects absurd sizes in damaged files
+
+static uint32_t Read32(const char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t Hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HashBits);
+}
+
+static void WriteFixed32(char* out, uint32_t value) {
+    for (int i = 0; i < 4; i++)
+        out[i] = (char)(value >> (i * 8));
+}
+
+static uint32_t ReadFixed32(const char* p) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++)
+        value |= (uint32_t)(uint8_t)p[i] << (i * 8);
+    return value;
+}
+
+// Lengths of 15 and up continue in extra bytes: 255s, then the remainder
+static char* WriteLength(char* out, size_t length) {
+    for (length -= 15; length >= 255; length -= 255)
+        *out++ = (char)255;
+    *out++ = (char)length;
+    return out;
+}
+
+static const char* ReadLength(const char* p, const char* end, size_t& length) {
+    uint8_t byte;
+    do {
+        if (p >= end)
+            return nullptr;
+        byte = (uint8_t)*p++;
+        length += byte;
+    } while (byte == 255);
+    return p;
+}
+
+static char* WriteSequence(char* out, const char* literals, size_t literalLength, size_t offset, size_t matchLength) {
+    char* token = out++;
+    *token = (char)((std::min<size_t>(literalLength, 15) << 4));
+    if (literalLength >= 15)
+        out = WriteLength(out, literalLength);
+    memcpy(out, literals, literalLength);
+    out += literalLength;
+    if (matchLength == 0)
+        return out;
+
+    out[0] = (char)(offset & 0xff);
+    out[1] = (char)(offset >> 8);
+    out += 2;
+    matchLength -= MinMatch;
+    *token |= (char)std::min<size_t>(matchLength, 15);
+    if (matchLength >= 15)
+        out = WriteLength(out, matchLength);
+    return out;
+}
+
+// Greedy single-probe matcher, like LZ4's fast mode: one hash slot per 4-byte sequence, and
+// the step grows while nothing matches so incompressible input passes through quickly
+size_t CompressBlock(const char* src, size_t size, char* dst) {
+    char* out = dst;
+    size_t anchor = 0;
+    if (size > MatchLimit) {
+        uint32_t table[1 << HashBits] = {};
+        size_t limit = size - MatchLimit;
+        size_t pos = 1;
+        table[Hash(Read32(src))] = 0;
+        unsigned misses = 0;
+        while (pos < limit) {
+            uint32_t sequence = Read32(src + pos);
+            uint32_t& slot = table[Hash(sequence)];
+            size_t candidate = slot;
+            slot = (uint32_t)pos;
+            if (candidate >= pos || pos - candidate > MaxOffset || Read32(src + candidate) != sequence) {
+                pos += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+
+            // Extend backwards over literals that also match, then forwards
+            while (pos > anchor && candidate > 0 && src[pos - 1] == src[candidate - 1]) {
+                pos--;
+                candidate--;
+            }
+            size_t length = MinMatch;
+            size_t matchEnd = size - LastLiterals;
+            while (pos + length < matchEnd && src[pos + length] == src[candidate + length])
+                length++;
+
+            out = WriteSequence(out, src + anchor, pos - anchor, pos - candidate, length);
+            pos += length;
+            anchor = pos;
+            if (pos < limit)
+                table[Hash(Read32(src + pos - 2))] = (uint32_t)(pos - 2);
+        }
+    }
+    return WriteSequence(out, src + anchor, size - anchor, 0, 0) - dst;
+}
+
+size_t DecompressBlock(const char* src, size_t size, char* dst, size_t capacity) {
+    const char* in = src;
+    const char* end = src + size;
+    size_t written = 0;
+    while (in < end) {
+        uint8_t token = (uint8_t)*in++;
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !(in = ReadLength(in, end, literalLength)))
+            return (size_t)-1;
+        if (literalLength > (size_t)(end - in) || literalLength > capacity - written)
+            return (size_t)-1;
+        memcpy(dst + written, in, literalLength);
+        in += literalLength;
+        written += literalLength;
+        if (in == end)
+            break;      // The last sequence has no match
+
+        if (end - in < 2)
+            return (size_t)-1;
+        size_t offset = (uint8_t)in[0] | ((size_t)(uint8_t)in[1] << 8);
+        in += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !(in = ReadLength(in, end, matchLength)))
+            return (size_t)-1;
+        matchLength += MinMatch;
+        if (offset == 0 || offset > written || matchLength > capacity - written)
+            return (size_t)-1;
+
+        // Overlapping matches repeat the bytes just written, so those copy one at a time
+        char* out = dst + written;
+        const char* match = out - offset;
+        if (offset >= matchLength)
+            memcpy(out, match, matchLength);
+        else
+            for (size_t i = 0; i < matchLength; i++)
+                out[i] = match[i];
+        written += matchLength;
+    }
+    return written;
+}
+
+bool CompressFile(const std::string& inPath, const std::string& outPath) {
+    MappedFile in;
+    if (!in.OpenRead(inPath))
+        return false;
+    size_t size = in.Size();
+    size_t blocks = (size + BlockSize - 1) / BlockSize;
+    MappedFile out;
+    if (!out.Create(outPath, sizeof(Magic) + blocks * (BlockHeaderSize + CompressBound(BlockSize))))
+        return false;
+
+    char* dst = out.Data();
+    memcpy(dst, Magic, sizeof(Magic));
+    size_t used = sizeof(Magic);
+    for (size_t offset = 0; offset < size; offset += BlockSize) {
+        size_t raw = std::min(BlockSize, size - offset);
+        char* header = dst + used;
+        char* body = header + BlockHeaderSize;
+        size_t stored = CompressBlock(in.Data() + offset, raw, body);
+        if (stored >= raw) {
+            memcpy(body, in.Data() + offset, raw);
+            stored = raw;
+        }
+        WriteFixed32(header, (uint32_t)raw);
+        WriteFixed32(header + 4, (uint32_t)stored);
+        used += BlockHeaderSize + stored;
+    }
+    out.Close(used);
+    return true;
+}
+
+bool Reader::Open(const std::string& path) {
+    if (!file.OpenRead(path))
+        return false;
+    pos = file.Data();
+    end = pos + file.Size();
+    truncated = false;
+    if (file.Size() < sizeof(Magic) || memcmp(pos, Magic, sizeof(Magic)) != 0) {
+        file.Close();
+        return false;
+    }
+    pos += sizeof(Magic);
+    return true;
+}
+
+size_t Reader::RawSize() const {
+    if (!file.IsOpen())
+        return 0;
+    size_t total = 0;
+    const char* p = file.Data() + sizeof(Magic);
+    while (p != end) {
+        if ((size_t)(end - p) < BlockHeaderSize)
+            return 0;
+        size_t raw = ReadFixed32(p);
+        size_t stored = ReadFixed32(p + 4);
+        if (raw > MaxRawBlock || stored > raw || stored > (size_t)(end - p) - BlockHeaderSize)
+            return 0;
+        total += raw;
+        p += BlockHeaderSize + stored;
+    }
+    return total;
+}
+
+bool Reader::Next(const char*& text, size_t& length) {
+    if (!file.IsOpen() || pos == end)
+        return false;
+    if ((size_t)(end - pos) < BlockHeaderSize) {
+        truncated = true;
+        return false;
+    }
+    size_t raw = ReadFixed32(pos);
+    size_t stored = ReadFixed32(pos + 4);
+    pos += BlockHeaderSize;
+    if (raw > MaxRawBlock || stored > raw || stored > (size_t)(end - pos)) {
+        truncated = true;
+        return false;
+    }
+
+    const char* body = pos;
+    pos += stored;
+    if (stored == raw) {
+        text = body;
+        length = raw;
+        return true;
+    }
+    block.resize(raw);
+    if (DecompressBlock(body, stored, block.data(), raw) != raw) {
+        truncated = true;
+        return false;
+    }
+    text = block.data();
+    length = raw;
+    return true;
+}
+
+}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ClassGame {
+
+// Compressed archives of finished log segments (game_log.0001.txt.glz). A file is
+//
+//   header   "GLOGLZ41"
+//   block    uint32 raw size, uint32 stored size (little endian), stored bytes
+//
+// Each block is up to BlockSize bytes of the original text, compressed independently in the
+// LZ4 block format; a block whose stored size equals its raw size didn't compress and is kept
+// as is. Independent blocks let a reader stream the file without holding all of it.
+namespace LogCompress {
+
+constexpr char Magic[8] = { 'G', 'L', 'O', 'G', 'L', 'Z', '4', '1' };
+constexpr size_t BlockSize = 64 * 1024;
+constexpr size_t BlockHeaderSize = 8;
+constexpr const char* Extension = ".glz";
+constexpr const char* PartialExtension = ".glz.part";  // An archive still being written
+
+// Worst-case compressed size of size input bytes
+constexpr size_t CompressBound(size_t size) { return size + size / 255 + 16; }
+
+// LZ4 block format. dst needs CompressBound(size) bytes; returns the bytes written.
+size_t CompressBlock(const char* src, size_t size, char* dst);
+// Returns the bytes written to dst, or (size_t)-1 for a damaged block or one larger than capacity
+size_t DecompressBlock(const char* src, size_t size, char* dst, size_t capacity);
+
+// Compress the file at inPath into a new archive at outPath. False if either can't be opened.
+bool CompressFile(const std::string& inPath, const std::string& outPath);
+
+// Streams an archive back to text one block at a time
+class Reader {
+public:
+    bool Open(const std::string& path);
+
+    // Length of the original text, from the block headers alone; 0 if they're damaged
+    size_t RawSize() const;
+
+    // The next block of text, valid until the following call. False at the end of the file or
+    // on a damaged block (see Truncated()).
+    bool Next(const char*& text, size_t& length);
+    bool Truncated() const { return truncated; }
+
+private:
+    MappedFile file;
+    const char* pos = nullptr;
+    const char* end = nullptr;
+    std::string block;
+    bool truncated = false;
+};
+
+}
+
+}
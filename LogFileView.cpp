@@ -0,0 +1,178 @@
+#include "LogFileView.h"
+#include "LogCompress.h"
+#include "LogFormat.h"
+#include "Logger.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace ClassGame {
+
+static constexpr size_t IndexStep = 1024 * 1024;   // Bytes scanned between publishes
+
+// The "[LEVEL]" field of a line in the file format, if it has one
+static bool ParseLineLevel(std::string_view line, LogLevel& level) {
+    size_t start = TimestampCache::Length + 2;
+    if (line.size() <= start || line[0] != '[' || line[start - 1] != '[')
+        return false;
+    size_t end = line.find(']', start);
+    return end != std::string_view::npos && ParseLevelName(line.substr(start, end - start), level) &&
+           level != LogLevel::Count;
+}
+
+bool LogFileView::Open(const std::string& filePath) {
+    Close();
+
+    // Compressed segments have to be inflated; the headers give the size up front so the
+    // buffer never moves while the window reads from it
+    LogCompress::Reader archive;
+    if (archive.Open(filePath)) {
+        size = archive.RawSize();
+        inflated = std::make_unique<char[]>(size > 0 ? size : 1);
+        data = inflated.get();
+    }
+    else if (file.OpenRead(filePath)) {
+        size = file.Size();
+        data = file.Data() ? file.Data() : "";
+        // A segment that was never closed (the game died, or it's still being written) is
+        // zero-filled past its text, and trimmed to that text when it closes. Keep only whole
+        // lines so the zeros don't show up as rows and no read lands past the trim.
+        if (size > 0 && data[size - 1] == '\0') {
+            while (size > 0 && data[size - 1] != '\n')
+                --size;
+        }
+    }
+    else {
+        return false;
+    }
+
+    path = filePath;
+    cancel.store(false, std::memory_order_relaxed);
+    done.store(false, std::memory_order_release);
+    indexer = std::thread(&LogFileView::IndexLoop, this);
+    return true;
+}
+
+void LogFileView::Close() {
+    if (indexer.joinable()) {
+        cancel.store(true, std::memory_order_release);
+        indexer.join();
+    }
+    file.Close();
+    inflated.reset();
+    data = nullptr;
+    size = 0;
+    path.clear();
+    marks.clear();
+    lineCount.store(0, std::memory_order_relaxed);
+    indexedBytes.store(0, std::memory_order_relaxed);
+    foundLines = 0;
+    lineStart = 0;
+    done.store(true, std::memory_order_release);
+}
+
+float LogFileView::Progress() const {
+    if (!IsIndexing())
+        return 1.0f;
+    return size > 0 ? (float)((double)indexedBytes.load(std::memory_order_acquire) / (double)size) : 1.0f;
+}
+
+void LogFileView::IndexLoop() {
+    std::vector<uint64_t> batch;
+    size_t end = size;
+    if (inflated) {
+        LogCompress::Reader archive;
+        archive.Open(path);
+        const char* text;
+        size_t length;
+        size_t at = 0;
+        while (!cancel.load(std::memory_order_acquire) && archive.Next(text, length) && length <= size - at) {
+            memcpy(inflated.get() + at, text, length);
+            IndexRange(at, at + length, batch);
+            at += length;
+        }
+        end = at;       // Short of the headers' total if a block is damaged
+    }
+    else {
+        for (size_t at = 0; at < size && !cancel.load(std::memory_order_acquire); at += IndexStep)
+            IndexRange(at, std::min(size, at + IndexStep), batch);
+    }
+
+    // The last line needn't end in a newline
+    if (!cancel.load(std::memory_order_acquire) && lineStart < end) {
+        if (foundLines % LinesPerMark == 0)
+            batch.push_back(lineStart);
+        foundLines++;
+        Publish(batch, foundLines, end);
+    }
+    done.store(true, std::memory_order_release);
+}
+
+void LogFileView::IndexRange(size_t from, size_t to, std::vector<uint64_t>& batch) {
+    const char* p = data + from;
+    const char* end = data + to;
+    while (const char* newline = (const char*)memchr(p, '\n', (size_t)(end - p))) {
+        if (foundLines % LinesPerMark == 0)
+            batch.push_back(lineStart);
+        foundLines++;
+        p = newline + 1;
+        lineStart = (size_t)(p - data);
+    }
+    Publish(batch, foundLines, to);
+}
+
+void LogFileView::Publish(std::vector<uint64_t>& batch, size_t lines, size_t bytes) {
+    if (!batch.empty()) {
+        std::lock_guard<std::mutex> lock(marksMutex);
+        marks.insert(marks.end(), batch.begin(), batch.end());
+        batch.clear();
+    }
+    indexedBytes.store(bytes, std::memory_order_release);
+    lineCount.store(lines, std::memory_order_release);
+}
+
+// Start from the nearest mark at or before the line and skip forward
+std::string_view LogFileView::Line(size_t line) const {
+    size_t start;
+    {
+        std::lock_guard<std::mutex> lock(marksMutex);
+        start = (size_t)marks[line / LinesPerMark];
+    }
+    const char* limit = data + indexedBytes.load(std::memory_order_acquire);
+    const char* p = data + start;
+    for (size_t skip = line % LinesPerMark; skip > 0; skip--)
+        p = (const char*)memchr(p, '\n', (size_t)(limit - p)) + 1;
+    const char* end = (const char*)memchr(p, '\n', (size_t)(limit - p));
+    if (!end)
+        end = limit;
+    if (end > p && end[-1] == '\r')
+        end--;
+    return std::string_view(p, (size_t)(end - p));
+}
+
+void LogFileView::Draw(const char* id, const ImVec2& size) {
+    ImGui::BeginChild(id, size, true, ImGuiWindowFlags_HorizontalScrollbar);
+    if (!IsOpen()) {
+        ImGui::EndChild();
+        return;
+    }
+
+    ImGuiListClipper clipper;
+    clipper.Begin((int)std::min<size_t>(LineCount(), INT_MAX));
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            std::string_view line = Line((size_t)row);
+            LogLevel level;
+            bool colored = ParseLineLevel(line, level);
+            if (colored)
+                ImGui::PushStyleColor(ImGuiCol_Text, Logger::GetLevelColor(level));
+            ImGui::TextUnformatted(line.data(), line.data() + line.size());
+            if (colored)
+                ImGui::PopStyleColor();
+        }
+    }
+    clipper.End();
+    ImGui::EndChild();
+}
+
+}
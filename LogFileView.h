@@ -0,0 +1,69 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "imgui/imgui.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace ClassGame {
+
+// Read-only view of a log file on disk (game_log.txt, a rotated segment, or a compressed .glz
+// segment), for files far larger than the history. Text files are memory-mapped rather than
+// read; a background thread finds the line breaks while the window already shows what it has
+// covered. The index keeps the offset of every LinesPerMark-th line, and a row is found by
+// scanning forward from its mark, so it costs 8 bytes per 16 lines (about 500 bytes per
+// thousand). Only the rows ImGuiListClipper reports as visible are touched each frame.
+class LogFileView {
+public:
+    static constexpr size_t LinesPerMark = 16;
+
+    LogFileView() = default;
+    ~LogFileView() { Close(); }
+    LogFileView(const LogFileView&) = delete;
+    LogFileView& operator=(const LogFileView&) = delete;
+
+    // Replaces any file already open. False if it can't be read.
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return data != nullptr; }
+    const std::string& GetPath() const { return path; }
+
+    // Lines indexed so far, and how far through the file the index is (0 to 1)
+    size_t LineCount() const { return lineCount.load(std::memory_order_acquire); }
+    float Progress() const;
+    bool IsIndexing() const { return !done.load(std::memory_order_acquire); }
+
+    // Draw inside a child region of the given size (ImGui::BeginChild semantics)
+    void Draw(const char* id, const ImVec2& size);
+
+private:
+    void IndexLoop();
+    void IndexRange(size_t from, size_t to, std::vector<uint64_t>& batch);
+    void Publish(std::vector<uint64_t>& batch, size_t lines, size_t bytes);
+    std::string_view Line(size_t line) const;
+
+    std::string path;
+    MappedFile file;                        // Plain text files
+    std::unique_ptr<char[]> inflated;       // Compressed files, decompressed by the index thread
+    const char* data = nullptr;
+    size_t size = 0;
+
+    std::thread indexer;
+    std::atomic<bool> cancel{ false };
+    std::atomic<bool> done{ true };
+    std::atomic<size_t> lineCount{ 0 };
+    std::atomic<size_t> indexedBytes{ 0 };
+    size_t foundLines = 0;                  // Index thread only, published through lineCount
+    size_t lineStart = 0;                   // Index thread only: where the current line began
+
+    mutable std::mutex marksMutex;          // Guards marks while the index thread appends
+    std::vector<uint64_t> marks;            // marks[k] = offset of line k * LinesPerMark
+};
+
+}
@@ -0,0 +1,194 @@
+#include "LogFlightRecorder.h"
+#include "LogFormat.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace ClassGame {
+
+static const char Magic[8] = { 'G', 'L', 'O', 'G', 'F', 'L', 'T', '1' };
+static constexpr size_t HeaderSize = 64;
+static constexpr size_t TagSize = 20;
+static constexpr size_t TextSize = LogFlightRecorder::SlotSize - 24 - TagSize;
+
+struct FlightHeader {
+    char magic[8];
+    uint32_t slotSize;
+    uint32_t slotCount;
+    std::atomic<uint32_t> clean;        // Set once closed or dumped
+    int32_t utcOffsetSeconds;           // Taken at Open, so a dump needn't call localtime
+};
+
+// Seqlock-style slot: sequence is 0 while the slot is being written, then 1 + its position
+struct FlightSlot {
+    std::atomic<uint64_t> sequence;
+    int64_t timeMs;
+    LogLevel level;
+    uint8_t tagLength;
+    uint16_t messageLength;
+    uint32_t reserved;
+    char tag[TagSize];
+    char text[TextSize];
+};
+static_assert(sizeof(FlightSlot) == LogFlightRecorder::SlotSize, "flight recorder slots are fixed-size");
+
+bool LogFlightRecorder::Open(const std::string& path, size_t entries) {
+    Close();
+    slotCount = entries > 0 ? entries : 1;
+    if (!file.Create(path, HeaderSize + slotCount * SlotSize))
+        return false;
+
+    // The file starts zeroed, so every slot reads as empty
+    FlightHeader* header = (FlightHeader*)file.Data();
+    memcpy(header->magic, Magic, sizeof(Magic));
+    header->slotSize = (uint32_t)SlotSize;
+    header->slotCount = (uint32_t)slotCount;
+    header->utcOffsetSeconds = UtcOffsetSeconds(std::time(nullptr));
+    header->clean.store(0, std::memory_order_release);
+    nextPosition.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void LogFlightRecorder::Close() {
+    if (!file.IsOpen())
+        return;
+    ((FlightHeader*)file.Data())->clean.store(1, std::memory_order_release);
+    file.Close();
+}
+
+void LogFlightRecorder::Record(int64_t timeMs, LogLevel level, std::string_view tag, std::string_view message) {
+    if (!file.IsOpen())
+        return;
+
+    uint64_t pos = nextPosition.fetch_add(1, std::memory_order_relaxed);
+    FlightSlot& slot = ((FlightSlot*)(file.Data() + HeaderSize))[pos % slotCount];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.timeMs = timeMs;
+    slot.level = level;
+    slot.tagLength = (uint8_t)(tag.size() < TagSize ? tag.size() : TagSize);
+    slot.messageLength = (uint16_t)(message.size() < TextSize ? message.size() : TextSize);
+    if (slot.tagLength > 0)
+        memcpy(slot.tag, tag.data(), slot.tagLength);
+    if (slot.messageLength > 0)
+        memcpy(slot.text, message.data(), slot.messageLength);
+    slot.sequence.store(pos + 1, std::memory_order_release);
+}
+
+size_t LogFlightRecorder::Dump(const char* outPath) {
+    if (!file.IsOpen())
+        return 0;
+    size_t written = DumpRing(file.Data(), file.Size(), outPath);
+    ((FlightHeader*)file.Data())->clean.store(1, std::memory_order_release);
+    return written;
+}
+
+size_t LogFlightRecorder::Recover(const std::string& ringPath, const std::string& outPath) {
+    MappedFile ring;
+    if (!ring.OpenRead(ringPath) || ring.Size() < HeaderSize)
+        return 0;
+    const FlightHeader* header = (const FlightHeader*)ring.Data();
+    if (header->clean.load(std::memory_order_acquire) != 0)
+        return 0;
+    return DumpRing(ring.Data(), ring.Size(), outPath.c_str());
+}
+
+// No heap, no stdio, no localtime: safe for a crash handler. Times use the UTC offset from
+// when the ring was opened. Slots caught mid-write are skipped.
+size_t LogFlightRecorder::DumpRing(const char* data, size_t size, const char* outPath) {
+    const FlightHeader* header = (const FlightHeader*)data;
+    if (size < HeaderSize || memcmp(header->magic, Magic, sizeof(Magic)) != 0 || header->slotSize != SlotSize)
+        return 0;
+    size_t count = header->slotCount;
+    if (count == 0 || HeaderSize + count * SlotSize > size)
+        return 0;
+    const FlightSlot* slots = (const FlightSlot*)(data + HeaderSize);
+
+    // The newest entry has the highest sequence; the ring holds the count positions before it
+    uint64_t newest = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t sequence = slots[i].sequence.load(std::memory_order_acquire);
+        if (sequence > newest)
+            newest = sequence;
+    }
+    if (newest == 0)
+        return 0;
+
+#ifdef _WIN32
+    int fd = -1;
+    _sopen_s(&fd, outPath, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE);
+#else
+    int fd = open(outPath, O_WRONLY | O_CREAT | O_APPEND, 0644);
+#endif
+    if (fd < 0)
+        return 0;
+    auto writeAll = [fd](const char* bytes, size_t length) {
+        while (length > 0) {
+#ifdef _WIN32
+            int n = _write(fd, bytes, (unsigned int)length);
+#else
+            ssize_t n = write(fd, bytes, length);
+#endif
+            if (n <= 0)
+                return;
+            bytes += n;
+            length -= (size_t)n;
+        }
+    };
+
+    static const char Banner[] = "---- Flight recorder: last entries before the crash ----\n";
+    writeAll(Banner, sizeof(Banner) - 1);
+
+    char line[TimestampCache::Length + 16 + TagSize + 3 + TextSize + 1];
+    size_t written = 0;
+    for (uint64_t pos = newest > count ? newest - count : 0; pos < newest; pos++) {
+        const FlightSlot& slot = slots[pos % count];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+            continue;
+
+        // Same layout as AppendLogLine: [HH:MM:SS.mmm] [LEVEL] [TAG] message
+        size_t length = FormatTimestamp(slot.timeMs, header->utcOffsetSeconds, line);
+        const char* levelName = GetLevelName(slot.level < LogLevel::Count ? slot.level : LogLevel::Error);
+        line[length++] = ' ';
+        line[length++] = '[';
+        size_t nameLength = strlen(levelName);
+        memcpy(line + length, levelName, nameLength);
+        length += nameLength;
+        line[length++] = ']';
+        line[length++] = ' ';
+        size_t tagLength = slot.tagLength < TagSize ? slot.tagLength : TagSize;
+        if (tagLength > 0) {
+            line[length++] = '[';
+            memcpy(line + length, slot.tag, tagLength);
+            length += tagLength;
+            line[length++] = ']';
+            line[length++] = ' ';
+        }
+        size_t messageLength = slot.messageLength < TextSize ? slot.messageLength : TextSize;
+        memcpy(line + length, slot.text, messageLength);
+        length += messageLength;
+        line[length++] = '\n';
+
+        // Overwritten while we copied it
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != pos + 1)
+            continue;
+        writeAll(line, length);
+        written++;
+    }
+
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+    return written;
+}
+
+}
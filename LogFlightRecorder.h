@@ -0,0 +1,50 @@
+#pragma once
+
+#include "LogRecord.h"
+#include "MappedFile.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ClassGame {
+
+// The last N entries in a fixed memory-mapped ring (game_log.flight). Entries are copied in as
+// they are logged, before any buffering, and the pages belong to the OS as soon as they're
+// written, so the ring outlives a crash of the process even when no handler gets to run.
+// Dump writes it out as text using only stack buffers and raw writes, for crash handlers.
+// A ring that wasn't closed or dumped is recovered by the next run (Recover).
+class LogFlightRecorder {
+public:
+    static constexpr size_t SlotSize = 256;
+
+    LogFlightRecorder() = default;
+    ~LogFlightRecorder() { Close(); }
+    LogFlightRecorder(const LogFlightRecorder&) = delete;
+    LogFlightRecorder& operator=(const LogFlightRecorder&) = delete;
+
+    // Create the ring file, replacing any previous one
+    bool Open(const std::string& path, size_t entries);
+    // Mark the ring as cleanly finished and unmap it
+    void Close();
+    bool IsOpen() const { return file.IsOpen(); }
+
+    // Any thread. Tag and message are truncated to fit a slot.
+    void Record(int64_t timeMs, LogLevel level, std::string_view tag, std::string_view message);
+
+    // Append the ring, oldest first, as text lines to outPath. Marks it clean so the next run
+    // doesn't dump it again. Returns the number of entries written.
+    size_t Dump(const char* outPath);
+
+    // Dump the ring at ringPath if the process that wrote it died without closing or dumping it
+    static size_t Recover(const std::string& ringPath, const std::string& outPath);
+
+private:
+    static size_t DumpRing(const char* data, size_t size, const char* outPath);
+
+    MappedFile file;
+    size_t slotCount = 0;
+    std::atomic<uint64_t> nextPosition{ 0 };
+};
+
+}
@@ -0,0 +1,142 @@
+#include "LogFormat.h"
+#include <cctype>
+#include <cstring>
+
+namespace ClassGame {
+
+static const char* LevelNames[] = { "INFO", "WARN", "ERROR" };
+
+const char* GetLevelName(LogLevel level) {
+    return level < LogLevel::Count ? LevelNames[(int)level] : "OFF";
+}
+
+bool ParseLevelName(std::string_view name, LogLevel& level) {
+    static const struct { const char* name; LogLevel level; } Names[] = {
+        { "INFO", LogLevel::Info },
+        { "WARN", LogLevel::Warning },
+        { "WARNING", LogLevel::Warning },
+        { "ERROR", LogLevel::Error },
+        { "OFF", LogLevel::Count },
+    };
+    for (const auto& entry : Names) {
+        size_t len = strlen(entry.name);
+        if (len != name.size())
+            continue;
+        size_t i = 0;
+        while (i < len && toupper((unsigned char)name[i]) == entry.name[i])
+            i++;
+        if (i == len) {
+            level = entry.level;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ToLocalTime(std::time_t time, std::tm& tm) {
+#ifdef _WIN32
+    localtime_s(&tm, &time);
+#else
+    localtime_r(&time, &tm);
+#endif
+}
+
+int32_t UtcOffsetSeconds(std::time_t time) {
+    std::tm local;
+    std::tm utc;
+    ToLocalTime(time, local);
+#ifdef _WIN32
+    gmtime_s(&utc, &time);
+#else
+    gmtime_r(&time, &utc);
+#endif
+    // The two are at most a day apart
+    int days = local.tm_yday - utc.tm_yday;
+    if (local.tm_year != utc.tm_year)
+        days = local.tm_year > utc.tm_year ? 1 : -1;
+    return ((days * 24 + local.tm_hour - utc.tm_hour) * 60 + local.tm_min - utc.tm_min) * 60 +
+           local.tm_sec - utc.tm_sec;
+}
+
+// "00".."99" so each pair of digits is a single 2-byte copy
+static const char DigitPairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static inline void WriteTwoDigits(char* out, int value) {
+    memcpy(out, DigitPairs + value * 2, 2);
+}
+
+size_t TimestampCache::Format(int64_t timeMs, char* out) {
+    int64_t second = timeMs >= 0 ? timeMs / 1000 : (timeMs - 999) / 1000;
+    int millis = (int)(timeMs - second * 1000);
+
+    if (second != cachedSecond) {
+        std::tm tm;
+        ToLocalTime((std::time_t)second, tm);
+        WriteTwoDigits(clock, tm.tm_hour);
+        clock[2] = ':';
+        WriteTwoDigits(clock + 3, tm.tm_min);
+        clock[5] = ':';
+        WriteTwoDigits(clock + 6, tm.tm_sec < 60 ? tm.tm_sec : 59);
+        cachedSecond = second;
+    }
+
+    out[0] = '[';
+    memcpy(out + 1, clock, sizeof(clock));
+    out[9] = '.';
+    out[10] = (char)('0' + millis / 100);
+    WriteTwoDigits(out + 11, millis % 100);
+    out[13] = ']';
+    return Length;
+}
+
+size_t FormatTimestamp(int64_t timeMs, int32_t utcOffsetSeconds, char* out) {
+    const int64_t DayMs = 24 * 60 * 60 * 1000;
+    int64_t ms = (timeMs + (int64_t)utcOffsetSeconds * 1000) % DayMs;
+    if (ms < 0)
+        ms += DayMs;
+    int millis = (int)(ms % 1000);
+    out[0] = '[';
+    WriteTwoDigits(out + 1, (int)(ms / 3600000));
+    out[3] = ':';
+    WriteTwoDigits(out + 4, (int)(ms / 60000 % 60));
+    out[6] = ':';
+    WriteTwoDigits(out + 7, (int)(ms / 1000 % 60));
+    out[9] = '.';
+    out[10] = (char)('0' + millis / 100);
+    WriteTwoDigits(out + 11, millis % 100);
+    out[13] = ']';
+    return TimestampCache::Length;
+}
+
+void FormatLogLine(std::string& out, int64_t timeMs, LogLevel level, std::string_view tag, std::string_view message) {
+    out.clear();
+    AppendLogLine(out, timeMs, level, tag, message);
+    out.pop_back();
+}
+
+void AppendLogLine(std::string& out, int64_t timeMs, LogLevel level, std::string_view tag, std::string_view message) {
+    // Each thread that formats (render thread, async writer) gets its own cache
+    static thread_local TimestampCache timestamps;
+
+    // Format: [HH:MM:SS.mmm] [LEVEL] 
+    char prefix[TimestampCache::Length];
+    out.append(prefix, timestamps.Format(timeMs, prefix));
+    out += " [";
+    out.append(GetLevelName(level));
+    out += "] ";
+
+    // Add tag ([GAME])
+    if (!tag.empty()) {
+        out += '[';
+        out.append(tag);
+        out += "] ";
+    }
+
+    out.append(message);
+    out += '\n';
+}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "LogRecord.h"
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+namespace ClassGame {
+
+// Text form shared by the file writer, console and Game Log window:
+// [HH:MM:SS.mmm] [LEVEL] [TAG] message
+
+const char* GetLevelName(LogLevel level);
+
+// Case-insensitive INFO/WARN/WARNING/ERROR/OFF, OFF maps to LogLevel::Count
+bool ParseLevelName(std::string_view name, LogLevel& level);
+
+// Portable localtime_s/localtime_r
+void ToLocalTime(std::time_t time, std::tm& tm);
+
+// Local time minus UTC at the given moment, in seconds
+int32_t UtcOffsetSeconds(std::time_t time);
+
+// Writes "[HH:MM:SS.mmm]" from a fixed UTC offset with arithmetic alone: no localtime, no
+// locks, so it is async-signal-safe. Returns TimestampCache::Length.
+size_t FormatTimestamp(int64_t timeMs, int32_t utcOffsetSeconds, char* out);
+
+// Writes "[HH:MM:SS.mmm]" without stdio or streams. The localtime conversion is the
+// expensive part, so the "HH:MM:SS" digits are cached and only rebuilt when the second changes.
+// Not thread-safe; keep one per thread.
+class TimestampCache {
+public:
+    static constexpr size_t Length = 14;
+
+    // out must have room for Length chars, returns Length
+    size_t Format(int64_t timeMs, char* out);
+
+private:
+    int64_t cachedSecond = INT64_MIN;
+    char clock[8] = {};             // "HH:MM:SS"
+};
+
+// Replace out with the formatted line (no trailing newline)
+void FormatLogLine(std::string& out, int64_t timeMs, LogLevel level, std::string_view tag, std::string_view message);
+
+// Append the formatted line plus '\n' to out
+void AppendLogLine(std::string& out, int64_t timeMs, LogLevel level, std::string_view tag, std::string_view message);
+
+}
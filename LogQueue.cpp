@@ -0,0 +1,76 @@
+#include "LogQueue.h"
+
+namespace ClassGame {
+
+void LogQueue::Init(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+
+    slots = std::vector<Slot>(size);
+    for (size_t i = 0; i < size; i++)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+
+    mask = size - 1;
+    enqueuePos.store(0, std::memory_order_relaxed);
+    dequeuePos.store(0, std::memory_order_relaxed);
+}
+
+bool LogQueue::TryPush(LogLevel level, int64_t timeMs, uint16_t tagId, std::string_view message,
+                       const char* format) {
+    if (slots.empty())
+        return false;
+
+    // Claim a slot: its sequence equals our ticket when it's free for this lap
+    Slot* slot;
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        slot = &slots[pos & mask];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0) {
+            return false;
+        }
+        else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    if (slot->record.Assign(level, timeMs, tagId, message, format))
+        overflowAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    // Publish to the consumer
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+LogRecord* LogQueue::Front() {
+    if (slots.empty())
+        return nullptr;
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    Slot& slot = slots[pos & mask];
+    if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+        return nullptr;
+    return &slot.record;
+}
+
+void LogQueue::Pop() {
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    Slot& slot = slots[pos & mask];
+    slot.record.Release();
+    // Hand the slot back to producers for the next lap
+    slot.sequence.store(pos + mask + 1, std::memory_order_release);
+    dequeuePos.store(pos + 1, std::memory_order_relaxed);
+}
+
+size_t LogQueue::ApproxSize() const {
+    size_t head = enqueuePos.load(std::memory_order_relaxed);
+    size_t tail = dequeuePos.load(std::memory_order_relaxed);
+    return head > tail ? head - tail : 0;
+}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "LogRecord.h"
+#include <atomic>
+#include <string_view>
+#include <vector>
+
+namespace ClassGame {
+
+// Bounded lock-free multi-producer / single-consumer ring of LogRecords.
+// Each slot carries a sequence number (Vyukov style) so producers only contend on one CAS.
+class LogQueue {
+public:
+    LogQueue() = default;
+    LogQueue(const LogQueue&) = delete;
+    LogQueue& operator=(const LogQueue&) = delete;
+
+    // Capacity is rounded up to a power of two. Not thread-safe, call before producers start.
+    void Init(size_t capacity);
+
+    // Producers: copy the entry into a free slot. Returns false when the ring is full.
+    // With a format, message holds that format's encoded arguments instead of text.
+    bool TryPush(LogLevel level, int64_t timeMs, uint16_t tagId, std::string_view message,
+                 const char* format = nullptr);
+
+    // Consumer only: peek the oldest record, then release it with Pop().
+    LogRecord* Front();
+    void Pop();
+
+    size_t Capacity() const { return mask + 1; }
+    size_t ApproxSize() const;
+    
+    // Messages longer than LogRecord::InlineSize that needed a heap block
+    size_t OverflowAllocations() const { return overflowAllocations.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    std::vector<Slot> slots;
+    size_t mask = 0;
+    std::atomic<size_t> overflowAllocations{ 0 };
+    alignas(64) std::atomic<size_t> enqueuePos{ 0 };
+    alignas(64) std::atomic<size_t> dequeuePos{ 0 };   // Written by the consumer only
+};
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+namespace ClassGame {
+
+enum class LogLevel : uint8_t {
+    Info = 0,
+    Warning,
+    Error,
+    Count
+};
+
+// Fixed-size record handed from producers to the background writer.
+// Short messages live inline, longer ones spill to a malloc'd block that the writer frees.
+struct LogRecord {
+    static constexpr size_t InlineSize = 200;
+
+    int64_t  timeMs;            // Milliseconds since epoch (system_clock)
+    LogLevel level;
+    uint16_t tagId;             // Interned by the Logger, names never move once added
+    uint32_t messageLength;
+    const char* format;         // Non-null: the text is LogBinary-encoded args for this printf format
+    char*    overflow;          // Non-null when the message didn't fit inline
+    char     text[InlineSize];
+
+    const char* Message() const { return overflow ? overflow : text; }
+
+    // Copy an entry in. Returns true if the message needed a heap block.
+    bool Assign(LogLevel entryLevel, int64_t entryTimeMs, uint16_t entryTagId, std::string_view message,
+                const char* entryFormat) {
+        timeMs = entryTimeMs;
+        level = entryLevel;
+        tagId = entryTagId;
+        messageLength = (uint32_t)message.size();
+        format = entryFormat;
+        overflow = nullptr;
+        if (message.size() <= InlineSize) {
+            if (!message.empty())
+                memcpy(text, message.data(), message.size());
+            return false;
+        }
+        overflow = (char*)malloc(message.size());
+        memcpy(overflow, message.data(), message.size());
+        return true;
+    }
+
+    void Release() {
+        free(overflow);
+        overflow = nullptr;
+    }
+};
+
+}
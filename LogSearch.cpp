@@ -0,0 +1,216 @@
+#include "LogSearch.h"
+#include "LogStore.h"
+#include <algorithm>
+#include <bit>
+
+namespace ClassGame {
+
+static inline uint8_t Fold(char c) {
+    return (c >= 'A' && c <= 'Z') ? (uint8_t)(c - 'A' + 'a') : (uint8_t)c;
+}
+
+// Case-folded trigrams of text in order of appearance; distinct and sorted when unique is set
+static void CollectTrigrams(std::string_view text, std::vector<uint32_t>& out, bool unique) {
+    out.clear();
+    if (text.size() < 3)
+        return;
+    uint32_t key = ((uint32_t)Fold(text[0]) << 8) | Fold(text[1]);
+    for (size_t i = 2; i < text.size(); i++) {
+        key = ((key << 8) | Fold(text[i])) & 0xffffff;
+        out.push_back(key);
+    }
+    if (unique) {
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+}
+
+// needle is already folded
+static bool ContainsFolded(std::string_view haystack, std::string_view needle) {
+    if (needle.size() > haystack.size())
+        return false;
+    for (size_t i = 0; i + needle.size() <= haystack.size(); i++) {
+        size_t j = 0;
+        while (j < needle.size() && Fold(haystack[i + j]) == (uint8_t)needle[j])
+            j++;
+        if (j == needle.size())
+            return true;
+    }
+    return false;
+}
+
+// lower_bound for a cursor that only moves forward: probe 1, 2, 4, ... ahead, then bisect
+static const uint64_t* Gallop(const uint64_t* pos, const uint64_t* end, uint64_t id) {
+    size_t step = 1;
+    while ((size_t)(end - pos) > step && pos[step] < id) {
+        pos += step;
+        step *= 2;
+    }
+    const uint64_t* limit = (size_t)(end - pos) > step ? pos + step + 1 : end;
+    return std::lower_bound(pos, limit, id);
+}
+
+static std::string FoldedText(std::string_view text) {
+    std::string folded(text);
+    for (char& c : folded)
+        c = (char)Fold(c);
+    return folded;
+}
+
+// Final check for a candidate id; needle is the folded query text
+static bool Matches(const LogStore& store, const LogQuery& query, std::string_view needle, uint64_t id) {
+    size_t i = (size_t)(id - store.FirstId());
+    if (query.level >= 0 && (int)store.GetLevel(i) != query.level)
+        return false;
+    if (query.tagId >= 0 && (int)store.GetTag(i) != query.tagId)
+        return false;
+    return needle.empty() || ContainsFolded(store.GetMessage(i), needle);
+}
+
+std::vector<uint64_t>& LogSearchIndex::List(uint32_t trigram) {
+    if (blockOf.empty())
+        blockOf.assign(1 << 16, 0);
+    uint32_t& block = blockOf[trigram >> 8];
+    if (block == 0) {
+        listOf.resize(listOf.size() + 256, 0);
+        block = (uint32_t)(listOf.size() / 256);
+    }
+    uint32_t& list = listOf[(size_t)(block - 1) * 256 + (trigram & 0xff)];
+    if (list == 0) {
+        lists.emplace_back();
+        list = (uint32_t)lists.size();
+    }
+    return lists[list - 1];
+}
+
+const std::vector<uint64_t>* LogSearchIndex::FindList(uint32_t trigram) const {
+    if (blockOf.empty() || blockOf[trigram >> 8] == 0)
+        return nullptr;
+    uint32_t list = listOf[(size_t)(blockOf[trigram >> 8] - 1) * 256 + (trigram & 0xff)];
+    return list != 0 ? &lists[list - 1] : nullptr;
+}
+
+void LogSearchIndex::Add(const LogStore& store, uint64_t id, std::string_view message) {
+    // A trigram repeated within the message finds its own id at the back of the list already
+    CollectTrigrams(message, scratch, false);
+    for (uint32_t key : scratch) {
+        std::vector<uint64_t>& list = List(key);
+        if (list.empty() || list.back() != id) {
+            list.push_back(id);
+            postingCount++;
+        }
+    }
+
+    if (++addsSincePrune >= store.Capacity())
+        Prune(store.FirstId());
+}
+
+void LogSearchIndex::Update(const LogStore& store) {
+    // Entries evicted (or cleared) before we got to them are skipped
+    if (indexedId < store.FirstId())
+        indexedId = store.FirstId();
+    for (; indexedId < store.NextId(); indexedId++)
+        Add(store, indexedId, store.GetMessage((size_t)(indexedId - store.FirstId())));
+}
+
+void LogSearchIndex::Prune(uint64_t firstId) {
+    for (std::vector<uint64_t>& list : lists) {
+        auto live = std::lower_bound(list.begin(), list.end(), firstId);
+        postingCount -= (size_t)(live - list.begin());
+        list.erase(list.begin(), live);
+    }
+    addsSincePrune = 0;
+}
+
+void LogSearchIndex::Clear() {
+    for (std::vector<uint64_t>& list : lists)
+        list.clear();
+    postingCount = 0;
+    addsSincePrune = 0;
+}
+
+void LogSearchIndex::Search(const LogStore& store, const LogQuery& query, std::vector<uint64_t>& ids) const {
+    ids.clear();
+    if (query.unknownTag || store.Empty())
+        return;
+
+    const uint64_t firstId = store.FirstId();
+    std::string needle = FoldedText(query.text);
+
+    // Substring: walk the shortest posting list and probe the others, then verify
+    std::vector<uint32_t> keys;
+    CollectTrigrams(needle, keys, true);
+    if (!keys.empty()) {
+        struct Cursor { const uint64_t* pos; const uint64_t* end; };
+        std::vector<Cursor> cursors;
+        for (uint32_t key : keys) {
+            const std::vector<uint64_t>* list = FindList(key);
+            if (!list)
+                return;
+            const uint64_t* end = list->data() + list->size();
+            const uint64_t* begin = std::lower_bound(list->data(), end, firstId);
+            cursors.push_back({ begin, end });
+        }
+        std::sort(cursors.begin(), cursors.end(), [](const Cursor& a, const Cursor& b) { return a.end - a.pos < b.end - b.pos; });
+
+        for (const uint64_t* it = cursors[0].pos; it != cursors[0].end; ++it) {
+            uint64_t id = *it;
+            bool inAll = true;
+            for (size_t l = 1; l < cursors.size() && inAll; l++) {
+                cursors[l].pos = Gallop(cursors[l].pos, cursors[l].end, id);
+                inAll = cursors[l].pos != cursors[l].end && *cursors[l].pos == id;
+            }
+            if (inAll && Matches(store, query, needle, id))
+                ids.push_back(id);
+        }
+        return;
+    }
+
+    // No trigrams: for tag/level-only queries walk the store's bitsets a word at a time
+    if (needle.empty()) {
+        const LogBitset* tagBits = query.tagId >= 0 ? store.TagBits((uint16_t)query.tagId) : nullptr;
+        if (query.tagId >= 0 && !tagBits)
+            return;
+        size_t capacity = store.Capacity();
+        size_t firstSlot = store.Slot(firstId);
+        size_t newer = 0;       // Slots below firstSlot hold the newer half of a wrapped ring
+        size_t words = (capacity + 63) / 64;
+        for (size_t w = 0; w < words; w++) {
+            uint64_t bits = 0;
+            for (int level = 0; level < (int)LogLevel::Count; level++) {
+                if (query.level < 0 || query.level == level)
+                    bits |= store.LevelBits((LogLevel)level).Word(w);
+            }
+            if (tagBits)
+                bits &= tagBits->Word(w);
+            for (; bits != 0; bits &= bits - 1) {
+                size_t slot = w * 64 + (size_t)std::countr_zero(bits);
+                ids.push_back(firstId + (slot + capacity - firstSlot) % capacity);
+                newer += slot < firstSlot;
+            }
+        }
+        std::rotate(ids.begin(), ids.begin() + newer, ids.end());
+        return;
+    }
+
+    // One or two characters: too short to index
+    Scan(store, query, ids);
+}
+
+void LogSearchIndex::Scan(const LogStore& store, const LogQuery& query, std::vector<uint64_t>& ids) {
+    ids.clear();
+    ScanFrom(store, query, store.FirstId(), ids);
+}
+
+void LogSearchIndex::ScanFrom(const LogStore& store, const LogQuery& query, uint64_t firstId,
+                              std::vector<uint64_t>& ids) {
+    if (query.unknownTag)
+        return;
+    std::string needle = FoldedText(query.text);
+    for (uint64_t id = std::max(firstId, store.FirstId()); id < store.NextId(); id++) {
+        if (Matches(store, query, needle, id))
+            ids.push_back(id);
+    }
+}
+
+}
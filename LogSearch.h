@@ -0,0 +1,61 @@
+#pragma once
+
+#include "LogRecord.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ClassGame {
+
+class LogStore;
+
+// Parsed search box text: "tag:GAME level:warn turn 3" = Warning entries tagged GAME whose
+// message contains "turn 3" (case-insensitive).
+struct LogQuery {
+    std::string text;               // Substring to find, may be empty
+    int level = -1;                 // LogLevel, -1 = any
+    int tagId = -1;                 // Interned tag id, -1 = any
+    bool unknownTag = false;        // tag: named a tag that was never logged, nothing can match
+};
+
+// Trigram index over the messages in a LogStore. Every entry adds its id to the posting list of
+// each distinct case-folded 3-byte sequence in its message; a substring search intersects the
+// lists for the query's trigrams and only verifies the surviving candidates. Postings for
+// evicted entries are trimmed lazily, about once per store capacity worth of appends.
+// Indexing runs in Update (once per frame and before a search) rather than per log call, so
+// logging itself stays cheap and entries evicted within a burst are never indexed.
+// Trigrams map to their lists through a two-level direct table (first two bytes, then the
+// third) rather than a hash map, so indexing an entry is a few array lookups per trigram.
+class LogSearchIndex {
+public:
+    // Index entries appended to the store since the last call
+    void Update(const LogStore& store);
+    void Clear();
+
+    // Matching ids, oldest first
+    void Search(const LogStore& store, const LogQuery& query, std::vector<uint64_t>& ids) const;
+    // Same result by testing every entry, for when no index is kept
+    static void Scan(const LogStore& store, const LogQuery& query, std::vector<uint64_t>& ids);
+    // Appends the matches among entries from firstId on, to extend an earlier result
+    static void ScanFrom(const LogStore& store, const LogQuery& query, uint64_t firstId, std::vector<uint64_t>& ids);
+
+    size_t TrigramCount() const { return lists.size(); }
+    size_t PostingCount() const { return postingCount; }
+
+private:
+    void Add(const LogStore& store, uint64_t id, std::string_view message);
+    std::vector<uint64_t>& List(uint32_t trigram);
+    const std::vector<uint64_t>* FindList(uint32_t trigram) const;
+    void Prune(uint64_t firstId);
+
+    std::vector<uint32_t> blockOf;          // First two bytes -> 1 + block number, 0 = none yet
+    std::vector<uint32_t> listOf;           // 256 per block, third byte -> 1 + list index
+    std::vector<std::vector<uint64_t>> lists;   // Ascending ids per trigram; emptied, never freed
+    size_t postingCount = 0;
+    uint64_t indexedId = 0;                 // Every id below this has been indexed or evicted
+    uint64_t addsSincePrune = 0;
+    std::vector<uint32_t> scratch;  // Trigrams of the entry being added
+};
+
+}
@@ -0,0 +1,422 @@
+#include "LogSinks.h"
+#include "LogFormat.h"
+#include "LogBinary.h"
+#include "LogCompress.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace ClassGame {
+
+// Raw file descriptor helpers - no CRT buffering, and safe enough to call from a crash handler
+static int OpenAppend(const char* path) {
+#ifdef _WIN32
+    int fd = -1;
+    _sopen_s(&fd, path, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE);
+    return fd;
+#else
+    return open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+#endif
+}
+
+static void WriteAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int written = _write(fd, data, (unsigned int)size);
+#else
+        ssize_t written = write(fd, data, size);
+#endif
+        if (written <= 0)
+            return;
+        data += written;
+        size -= (size_t)written;
+    }
+}
+
+static void CloseFd(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+const char* GetFlushPolicyName(FlushPolicy policy) {
+    switch (policy) {
+        case FlushPolicy::EveryEntry: return "Every entry";
+        case FlushPolicy::EveryFrame: return "Every frame";
+        case FlushPolicy::Interval:   return "Interval";
+        case FlushPolicy::OnError:    return "On error";
+    }
+    return "?";
+}
+
+// Default for sinks that only understand text
+void LogSink::WriteEncoded(int64_t timeMs, LogLevel level, std::string_view tag, const char* format,
+                           const char* args, size_t argsLength) {
+    thread_local std::string message;
+    LogBinary::FormatArgs(message, format, args, argsLength);
+    Write(timeMs, level, tag, message);
+}
+
+bool BufferedFileSink::Open(const std::string& path, size_t bufferSize, FlushPolicy flushPolicy, int flushIntervalMs) {
+    Close();
+    fd = OpenAppend(path.c_str());
+    if (fd < 0)
+        return false;
+
+    capacity = bufferSize > 0 ? bufferSize : 1;
+    buffer = (char*)malloc(capacity);
+    used = 0;
+    policy = flushPolicy;
+    intervalMs = flushIntervalMs;
+    return true;
+}
+
+void BufferedFileSink::Close() {
+    if (fd < 0)
+        return;
+    Flush();
+    CloseFd(fd);
+    fd = -1;
+    free(buffer);
+    buffer = nullptr;
+    capacity = used = 0;
+}
+
+void BufferedFileSink::Append(const char* data, size_t size, int64_t timeMs, LogLevel level) {
+    if (fd < 0)
+        return;
+
+    if (used + size > capacity)
+        Flush();
+    if (size > capacity) {
+        // Bigger than the whole buffer, skip the copy
+        WriteAll(fd, data, size);
+        bytesWritten += size;
+    }
+    else {
+        if (used == 0)
+            oldestPendingMs = timeMs;
+        memcpy(buffer + used, data, size);
+        used += size;
+    }
+
+    if (policy == FlushPolicy::EveryEntry || (policy == FlushPolicy::OnError && level == LogLevel::Error))
+        Flush();
+}
+
+void BufferedFileSink::Flush() {
+    if (fd < 0 || used == 0)
+        return;
+    WriteAll(fd, buffer, used);
+    bytesWritten += used;
+    used = 0;
+    flushes++;
+}
+
+void BufferedFileSink::OnFrameEnd() {
+    if (policy == FlushPolicy::EveryFrame)
+        Flush();
+}
+
+void BufferedFileSink::Poll(int64_t nowMs) {
+    if (policy == FlushPolicy::Interval && used > 0 && nowMs - oldestPendingMs >= intervalMs)
+        Flush();
+}
+
+void BufferedFileSink::CrashFlush() {
+    if (fd < 0 || used == 0)
+        return;
+    WriteAll(fd, buffer, used);
+    used = 0;
+}
+
+bool FileSink::Open(const std::string& path, size_t bufferSize, FlushPolicy flushPolicy, int flushIntervalMs) {
+    line.reserve(512);
+    return BufferedFileSink::Open(path, bufferSize, flushPolicy, flushIntervalMs);
+}
+
+void FileSink::Write(int64_t timeMs, LogLevel level, std::string_view tag, std::string_view message) {
+    if (!IsOpen())
+        return;
+
+    size_t lineCapacity = line.capacity();
+    line.clear();
+    AppendLogLine(line, timeMs, level, tag, message);
+    scratchGrowths += line.capacity() != lineCapacity;
+    Append(line.data(), line.size(), timeMs, level);
+}
+
+bool BinaryFileSink::Open(const std::string& path, size_t bufferSize, FlushPolicy flushPolicy, int flushIntervalMs) {
+    if (!BufferedFileSink::Open(path, bufferSize, flushPolicy, flushIntervalMs))
+        return false;
+
+    // New session: ids restart and timestamps are deltas from this base
+    tags.assign(1, std::string());
+    formats.clear();
+    record.reserve(512);
+    text.reserve(512);
+    lastTimeMs = (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    char header[LogBinary::SessionSize];
+    memcpy(header, LogBinary::Magic, sizeof(LogBinary::Magic));
+    for (int i = 0; i < 8; i++)
+        header[sizeof(LogBinary::Magic) + i] = (char)((uint64_t)lastTimeMs >> (i * 8));
+    Append(header, sizeof(header), lastTimeMs, LogLevel::Info);
+    return true;
+}
+
+void BinaryFileSink::Define(uint8_t type, uint32_t id, std::string_view text) {
+    char prefix[1 + 2 * LogBinary::MaxVarintSize];
+    size_t n = 0;
+    prefix[n++] = (char)type;
+    n += LogBinary::WriteVarint(prefix + n, id);
+    n += LogBinary::WriteVarint(prefix + n, text.size());
+
+    size_t recordCapacity = record.capacity();
+    record.assign(prefix, n);
+    record.append(text);
+    scratchGrowths += record.capacity() != recordCapacity;
+    Append(record.data(), record.size(), lastTimeMs, LogLevel::Info);
+}
+
+uint32_t BinaryFileSink::TagId(std::string_view tag) {
+    if (tag.empty())
+        return 0;
+    for (size_t i = 1; i < tags.size(); i++) {
+        if (tags[i] == tag)
+            return (uint32_t)i;
+    }
+    tags.emplace_back(tag);
+    scratchGrowths++;
+    Define(LogBinary::RecordTag, (uint32_t)(tags.size() - 1), tag);
+    return (uint32_t)(tags.size() - 1);
+}
+
+uint32_t BinaryFileSink::FormatId(const char* format) {
+    auto it = formats.find(format);
+    if (it != formats.end())
+        return it->second;
+    uint32_t id = (uint32_t)formats.size() + 1;    // 0 is the implicit "%s"
+    formats.emplace(format, id);
+    scratchGrowths++;
+    Define(LogBinary::RecordFormat, id, format);
+    return id;
+}
+
+void BinaryFileSink::WriteEncoded(int64_t timeMs, LogLevel level, std::string_view tag, const char* format,
+                                  const char* args, size_t argsLength) {
+    if (!IsOpen())
+        return;
+
+    uint32_t tagId = TagId(tag);
+    uint32_t formatId = format ? FormatId(format) : 0;
+
+    char header[1 + 4 * LogBinary::MaxVarintSize + 1];
+    size_t n = 0;
+    header[n++] = (char)LogBinary::RecordEntry;
+    n += LogBinary::WriteVarint(header + n, LogBinary::ZigZag(timeMs - lastTimeMs));
+    header[n++] = (char)level;
+    n += LogBinary::WriteVarint(header + n, tagId);
+    n += LogBinary::WriteVarint(header + n, formatId);
+    n += LogBinary::WriteVarint(header + n, argsLength);
+    lastTimeMs = timeMs;
+
+    size_t recordCapacity = record.capacity();
+    record.assign(header, n);
+    record.append(args, argsLength);
+    scratchGrowths += record.capacity() != recordCapacity;
+    Append(record.data(), record.size(), timeMs, level);
+}
+
+// Plain messages go out as format 0 with the text as its one string argument
+void BinaryFileSink::Write(int64_t timeMs, LogLevel level, std::string_view tag, std::string_view message) {
+    char prefix[1 + LogBinary::MaxVarintSize];
+    size_t n = 0;
+    prefix[n++] = (char)LogBinary::ArgString;
+    n += LogBinary::WriteVarint(prefix + n, message.size());
+
+    size_t textCapacity = text.capacity();
+    text.assign(prefix, n);
+    text.append(message);
+    scratchGrowths += text.capacity() != textCapacity;
+    WriteEncoded(timeMs, level, tag, nullptr, text.data(), text.size());
+}
+
+bool RotatingFileSink::Open(const std::string& basePath, size_t size, int64_t rotateMs, int keep,
+                            FlushPolicy flushPolicy, int flushIntervalMs) {
+    Close();
+    std::filesystem::path base(basePath);
+    stem = (base.parent_path() / base.stem()).string();
+    extension = base.extension().string();
+    segmentSize = size > 0 ? size : 1;
+    rotateIntervalMs = rotateMs;
+    maxSegments = keep > 0 ? keep : 1;
+    policy = flushPolicy;
+    intervalMs = flushIntervalMs;
+    line.reserve(512);
+
+    // Continue numbering after whatever earlier sessions left behind, archived or not. Archives
+    // a session died while writing are half-finished and go.
+    std::vector<int> found;
+    std::error_code error;
+    std::filesystem::path dir = base.parent_path().empty() ? std::filesystem::path(".") : base.parent_path();
+    std::string prefix = base.stem().string() + ".";
+    std::string partial = LogCompress::PartialExtension;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() > partial.size() && name.compare(0, prefix.size(), prefix) == 0 &&
+            name.compare(name.size() - partial.size(), partial.size(), partial) == 0) {
+            std::error_code removeError;
+            std::filesystem::remove(entry.path(), removeError);
+            continue;
+        }
+        std::string archived = LogCompress::Extension;
+        if (name.size() > archived.size() && name.compare(name.size() - archived.size(), archived.size(), archived) == 0)
+            name.resize(name.size() - archived.size());
+        if (name.size() <= prefix.size() + extension.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - extension.size(), extension.size(), extension) != 0)
+            continue;
+        std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - extension.size());
+        if (!digits.empty() && std::all_of(digits.begin(), digits.end(), ::isdigit))
+            found.push_back(atoi(digits.c_str()));
+    }
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    retained.assign(found.begin(), found.end());
+    segmentIndex = found.empty() ? 0 : found.back();
+
+    Roll(0);
+    return segment.IsOpen();
+}
+
+std::string RotatingFileSink::SegmentPath(int index) const {
+    char number[16];
+    snprintf(number, sizeof(number), ".%04d", index);
+    return stem + number + extension;
+}
+
+bool RotatingFileSink::OpenSegment(int64_t nowMs) {
+    currentPath = SegmentPath(segmentIndex);
+    used = 0;
+    dirty = false;
+    if (rotateIntervalMs > 0) {
+        int64_t now = nowMs > 0 ? nowMs : (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::system_clock::now().time_since_epoch()).count();
+        nextRollMs = (now / rotateIntervalMs + 1) * rotateIntervalMs;
+    }
+    if (!segment.Create(currentPath, segmentSize))
+        return false;
+    activeSegment.store(segmentIndex, std::memory_order_release);
+    return true;
+}
+
+void RotatingFileSink::CloseSegment() {
+    if (!segment.IsOpen())
+        return;
+    activeSegment.store(0, std::memory_order_release);
+    if (policy != FlushPolicy::OnError)
+        segment.Flush();
+    segment.Close(used);
+    if (onSegmentClosed)
+        onSegmentClosed(currentPath);
+}
+
+void RotatingFileSink::Roll(int64_t nowMs) {
+    CloseSegment();
+    segmentIndex++;
+    retained.push_back(segmentIndex);
+
+    // Bound disk usage: drop the oldest segments beyond the cap (the new one included)
+    while ((int)retained.size() > maxSegments) {
+        std::string path = SegmentPath(retained.front());
+        if (onSegmentExpired) {
+            onSegmentExpired(path);
+        }
+        else {
+            std::error_code error;
+            std::filesystem::remove(path, error);
+            std::filesystem::remove(path + LogCompress::Extension, error);
+        }
+        retained.pop_front();
+    }
+    OpenSegment(nowMs);
+}
+
+void RotatingFileSink::Close() {
+    CloseSegment();
+    retained.clear();
+}
+
+void RotatingFileSink::Write(int64_t timeMs, LogLevel level, std::string_view tag, std::string_view message) {
+    if (!segment.IsOpen())
+        return;
+
+    size_t lineCapacity = line.capacity();
+    line.clear();
+    AppendLogLine(line, timeMs, level, tag, message);
+    lineGrowths += line.capacity() != lineCapacity;
+
+    // Start a fresh segment on a wall-clock boundary, or when the line would straddle two files
+    if (used > 0 && ((rotateIntervalMs > 0 && timeMs >= nextRollMs) ||
+                     (used + line.size() > segmentSize && line.size() <= segmentSize)))
+        Roll(timeMs);
+
+    // Lines longer than a whole segment are split across as many as needed
+    const char* src = line.data();
+    size_t left = line.size();
+    while (left > 0 && segment.IsOpen()) {
+        if (used == segmentSize)
+            Roll(timeMs);
+        size_t count = std::min(left, segmentSize - used);
+        memcpy(segment.Data() + used, src, count);
+        used += count;
+        src += count;
+        left -= count;
+    }
+
+    if (!dirty) {
+        dirty = true;
+        oldestPendingMs = timeMs;
+    }
+    if (policy == FlushPolicy::EveryEntry || (policy == FlushPolicy::OnError && level == LogLevel::Error))
+        Flush();
+}
+
+// The mapping is already in the OS page cache, so "flush" here means scheduling writeback
+void RotatingFileSink::Flush() {
+    if (!dirty)
+        return;
+    segment.Flush();
+    dirty = false;
+}
+
+void RotatingFileSink::OnFrameEnd() {
+    if (policy == FlushPolicy::EveryFrame)
+        Flush();
+}
+
+void RotatingFileSink::Poll(int64_t nowMs) {
+    if (policy == FlushPolicy::Interval && dirty && nowMs - oldestPendingMs >= intervalMs)
+        Flush();
+}
+
+// Mapped pages survive the process dying; just trim the preallocated zero tail
+void RotatingFileSink::CrashFlush() {
+    segment.Truncate(used);
+}
+
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "LogRecord.h"
+#include "MappedFile.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ClassGame {
+
+// When a buffered sink pushes its buffer to the OS
+enum class FlushPolicy : uint8_t {
+    EveryEntry,     // Each line is written before Write returns (old behavior)
+    EveryFrame,     // Once per Logger::EndFrame
+    Interval,       // At most flushIntervalMs after the oldest unwritten line
+    OnError,        // Only when an Error arrives or the buffer fills
+};
+
+const char* GetFlushPolicyName(FlushPolicy policy);
+
+// Destination for formatted log lines. Sinks are driven from one thread at a time
+// (the render thread, or the async writer when it is running).
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+
+    virtual void Write(int64_t timeMs, LogLevel level, std::string_view tag, std::string_view message) = 0;
+    // An entry still in LogBinary form: a printf format with static storage plus its encoded
+    // arguments. Text sinks get it expanded and passed to Write.
+    virtual void WriteEncoded(int64_t timeMs, LogLevel level, std::string_view tag, const char* format,
+                              const char* args, size_t argsLength);
+    virtual void Flush() {}
+
+    // Frame boundary and periodic tick, for time/frame based flush policies
+    virtual void OnFrameEnd() {}
+    virtual void Poll(int64_t nowMs) {}
+
+    // Called from crash handlers: push out whatever is buffered using only raw OS writes
+    virtual void CrashFlush() {}
+
+    // Time of the oldest line not yet flushed, -1 when nothing is pending
+    virtual int64_t OldestPendingMs() const { return -1; }
+    // Heap allocations made while writing (scratch growth), for Logger::GetHeapAllocations
+    virtual size_t Allocations() const { return 0; }
+};
+
+// Shared plumbing for sinks that append to a file through a user-sized buffer: one write()
+// per flush instead of per entry, with the flush policy applied after each Append.
+class BufferedFileSink : public LogSink {
+public:
+    ~BufferedFileSink() override { Close(); }
+
+    bool Open(const std::string& path, size_t bufferSize, FlushPolicy policy, int flushIntervalMs);
+    void Close();
+    bool IsOpen() const { return fd >= 0; }
+
+    void Flush() override;
+    void OnFrameEnd() override;
+    void Poll(int64_t nowMs) override;
+    void CrashFlush() override;
+
+    int64_t OldestPendingMs() const override { return used > 0 ? oldestPendingMs : -1; }
+    size_t Allocations() const override { return scratchGrowths; }
+    size_t BufferedBytes() const { return used; }
+    size_t BytesWritten() const { return bytesWritten; }
+    size_t FlushCount() const { return flushes; }
+
+protected:
+    BufferedFileSink() = default;
+    BufferedFileSink(const BufferedFileSink&) = delete;
+    BufferedFileSink& operator=(const BufferedFileSink&) = delete;
+
+    // Buffer one complete entry (never split across flushes), then apply the flush policy
+    void Append(const char* data, size_t size, int64_t timeMs, LogLevel level);
+
+    size_t scratchGrowths = 0;      // Growth of the derived sink's reused scratch strings
+
+private:
+    int fd = -1;
+    char* buffer = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    FlushPolicy policy = FlushPolicy::Interval;
+    int64_t intervalMs = 100;
+    int64_t oldestPendingMs = 0;    // Time of the first entry buffered since the last flush
+    size_t bytesWritten = 0;
+    size_t flushes = 0;
+};
+
+// Appends "[HH:MM:SS.mmm] [LEVEL] [TAG] msg" lines to a text file
+class FileSink : public BufferedFileSink {
+public:
+    bool Open(const std::string& path, size_t bufferSize, FlushPolicy policy, int flushIntervalMs);
+    void Write(int64_t timeMs, LogLevel level, std::string_view tag, std::string_view message) override;
+
+private:
+    std::string line;               // Reused formatting scratch
+};
+
+// Appends LogBinary records (see LogBinary.h) to a .bin file. Formatted entries keep their
+// format string and raw arguments, so no text is produced until log_decode reads the file.
+// Each Open starts a new session with its own tag and format tables.
+class BinaryFileSink : public BufferedFileSink {
+public:
+    bool Open(const std::string& path, size_t bufferSize, FlushPolicy policy, int flushIntervalMs);
+
+    void Write(int64_t timeMs, LogLevel level, std::string_view tag, std::string_view message) override;
+    void WriteEncoded(int64_t timeMs, LogLevel level, std::string_view tag, const char* format,
+                      const char* args, size_t argsLength) override;
+
+private:
+    uint32_t TagId(std::string_view tag);
+    uint32_t FormatId(const char* format);
+    void Define(uint8_t type, uint32_t id, std::string_view text);
+
+    std::vector<std::string> tags{ "" };                    // Id 0 is "no tag"
+    std::unordered_map<const char*, uint32_t> formats;      // Keyed by the literal's address
+    int64_t lastTimeMs = 0;
+    std::string record;             // Reused encoding scratch
+    std::string text;               // Plain messages wrapped as a string argument
+};
+
+// Writes into fixed-size, preallocated memory-mapped segments: base "game_log.txt" becomes
+// "game_log.0001.txt", "game_log.0002.txt", ... A line is a memcpy into the mapping. A new
+// segment starts when the current one is full or a wall-clock boundary passes, and only the
+// newest maxSegments files are kept on disk (compressed ones, "game_log.0001.txt.glz", included).
+class RotatingFileSink : public LogSink {
+public:
+    RotatingFileSink() = default;
+    ~RotatingFileSink() override { Close(); }
+    RotatingFileSink(const RotatingFileSink&) = delete;
+    RotatingFileSink& operator=(const RotatingFileSink&) = delete;
+
+    // rotateIntervalMs = 0 rolls on size only
+    bool Open(const std::string& basePath, size_t segmentSize, int64_t rotateIntervalMs, int maxSegments,
+              FlushPolicy policy, int flushIntervalMs);
+    void Close();
+    bool IsOpen() const { return segment.IsOpen(); }
+
+    void Write(int64_t timeMs, LogLevel level, std::string_view tag, std::string_view message) override;
+    void Flush() override;
+    void OnFrameEnd() override;
+    void Poll(int64_t nowMs) override;
+    void CrashFlush() override;
+    int64_t OldestPendingMs() const override { return dirty ? oldestPendingMs : -1; }
+    size_t Allocations() const override { return lineGrowths; }
+
+    std::string SegmentPath(int index) const;
+    const std::string& CurrentPath() const { return currentPath; }
+    // Index of the segment being written, 0 when none is open. Any thread; the mapping behind
+    // it is truncated when it closes, so readers must leave it alone.
+    int ActiveSegment() const { return activeSegment.load(std::memory_order_acquire); }
+
+    // Runs on the writing thread after a segment is finished and trimmed to its used size
+    std::function<void(const std::string& path)> onSegmentClosed;
+    // Runs on the writing thread when retention drops a segment, and must delete it and its
+    // archive. Unset, they're deleted right away.
+    std::function<void(const std::string& path)> onSegmentExpired;
+
+private:
+    bool OpenSegment(int64_t nowMs);
+    void CloseSegment();
+    void Roll(int64_t nowMs);
+
+    std::string stem;               // "game_log"
+    std::string extension;          // ".txt"
+    MappedFile segment;
+    std::string currentPath;
+    size_t segmentSize = 0;
+    size_t used = 0;
+    int segmentIndex = 0;
+    std::atomic<int> activeSegment{ 0 };
+    std::deque<int> retained;       // Segment indices on disk, oldest first
+    int maxSegments = 10;
+    int64_t rotateIntervalMs = 0;
+    int64_t nextRollMs = 0;
+    FlushPolicy policy = FlushPolicy::Interval;
+    int64_t intervalMs = 100;
+    bool dirty = false;
+    int64_t oldestPendingMs = 0;
+    std::string line;
+    size_t lineGrowths = 0;
+};
+
+}
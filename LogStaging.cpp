@@ -0,0 +1,62 @@
+#include "LogStaging.h"
+
+namespace ClassGame {
+
+LogStaging::LogStaging(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+    records.resize(size);
+    mask = size - 1;
+}
+
+LogStaging::~LogStaging() {
+    while (Front())
+        Pop();
+}
+
+void LogStaging::Push(LogLevel level, int64_t timeMs, uint16_t tagId, std::string_view message,
+                      const char* format) {
+    size_t pos = head.load(std::memory_order_relaxed);
+    if (spillCount.load(std::memory_order_acquire) == 0 && pos - tail.load(std::memory_order_acquire) <= mask) {
+        if (records[pos & mask].Assign(level, timeMs, tagId, message, format))
+            overflowAllocations.fetch_add(1, std::memory_order_relaxed);
+        head.store(pos + 1, std::memory_order_release);
+        return;
+    }
+
+    // The main thread isn't keeping up; hold on to the entry until it does
+    std::lock_guard<std::mutex> lock(spillMutex);
+    spill.emplace_back();
+    bool overflow = spill.back().Assign(level, timeMs, tagId, message, format);
+    overflowAllocations.fetch_add(overflow ? 2 : 1, std::memory_order_relaxed);
+    spillCount.fetch_add(1, std::memory_order_release);
+}
+
+// The ring first: while the overflow list has entries the producer doesn't use the ring, so
+// whatever is in the ring is older
+LogRecord* LogStaging::Front() {
+    size_t pos = tail.load(std::memory_order_relaxed);
+    if (pos != head.load(std::memory_order_acquire))
+        return &records[pos & mask];
+    if (spillCount.load(std::memory_order_acquire) == 0)
+        return nullptr;
+    // References to deque elements survive push_back, so the record stays put without the lock
+    std::lock_guard<std::mutex> lock(spillMutex);
+    return &spill.front();
+}
+
+void LogStaging::Pop() {
+    size_t pos = tail.load(std::memory_order_relaxed);
+    if (pos != head.load(std::memory_order_acquire)) {
+        records[pos & mask].Release();
+        tail.store(pos + 1, std::memory_order_release);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(spillMutex);
+    spill.front().Release();
+    spill.pop_front();
+    spillCount.fetch_sub(1, std::memory_order_release);
+}
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "LogRecord.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace ClassGame {
+
+// Per-thread staging ring for entries logged off the main thread. One producer (the owning
+// thread) and one consumer (the main thread merging at the frame boundary), so a push is a
+// copy plus one release store - no locks, no CAS.
+// When the ring is full, entries go to a locked overflow list instead of being dropped, and
+// keep going there until the consumer has emptied it, so the thread's entries stay in order.
+class LogStaging {
+public:
+    explicit LogStaging(size_t capacity);
+    ~LogStaging();
+    LogStaging(const LogStaging&) = delete;
+    LogStaging& operator=(const LogStaging&) = delete;
+
+    // Producer: never fails, a full ring spills to the overflow list
+    void Push(LogLevel level, int64_t timeMs, uint16_t tagId, std::string_view message, const char* format);
+
+    // Consumer: oldest staged record, released with Pop()
+    LogRecord* Front();
+    void Pop();
+
+    size_t ApproxSize() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed) +
+               spillCount.load(std::memory_order_acquire);
+    }
+    // Message blocks too big to store inline, plus one per spilled record
+    size_t OverflowAllocations() const { return overflowAllocations.load(std::memory_order_relaxed); }
+
+    // Set by the owning thread when it exits; the consumer frees the ring once it's drained
+    std::atomic<bool> retired{ false };
+
+private:
+    std::vector<LogRecord> records;
+    size_t mask = 0;
+    std::atomic<size_t> overflowAllocations{ 0 };
+    alignas(64) std::atomic<size_t> head{ 0 };     // Next slot to write, producer-owned
+    alignas(64) std::atomic<size_t> tail{ 0 };     // Next slot to read, consumer-owned
+
+    // Overflow list; only the producer adds to it, and only the consumer empties it
+    std::mutex spillMutex;
+    std::deque<LogRecord> spill;                    // Newer than everything in the ring
+    std::atomic<size_t> spillCount{ 0 };
+};
+
+}
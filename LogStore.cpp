@@ -0,0 +1,116 @@
+#include "LogStore.h"
+#include <cstdio>
+#include <string>
+
+namespace ClassGame {
+
+void LogStore::SetCapacity(size_t newCapacity) {
+    if (newCapacity == capacity)
+        return;
+
+    // Pull the entries that survive out before the columns are reallocated
+    size_t keep = Size() < newCapacity ? Size() : newCapacity;
+    std::vector<int64_t> keptTimes(keep);
+    std::vector<LogLevel> keptLevels(keep);
+    std::vector<uint16_t> keptTags(keep);
+    std::vector<std::string> keptText(keep);
+    for (size_t i = 0; i < keep; i++) {
+        size_t src = Size() - keep + i;
+        keptTimes[i] = GetTime(src);
+        keptLevels[i] = GetLevel(src);
+        keptTags[i] = GetTag(src);
+        keptText[i] = std::string(GetMessage(src));
+    }
+
+    capacity = newCapacity;
+    times.assign(capacity, 0);
+    levels.assign(capacity, LogLevel::Info);
+    tags.assign(capacity, 0);
+    textPos.assign(capacity, 0);
+    textLength.assign(capacity, 0);
+    arena.Clear();
+    for (LogBitset& bits : levelBits)
+        bits.Resize(capacity);
+    for (LogBitset& bits : tagBits)
+        bits.Resize(capacity);
+    firstId = nextId;
+
+    for (size_t i = 0; i < keep; i++)
+        Append(keptTimes[i], keptLevels[i], keptTags[i], keptText[i]);
+}
+
+// Evict if needed and fill every column but the text; returns the slot of the new entry
+size_t LogStore::BeginAppend(int64_t timeMs, LogLevel level, uint16_t tagId) {
+    if (Size() == capacity) {
+        firstId++;
+        // The new oldest entry marks where live text starts
+        if (firstId < nextId)
+            arena.ReleaseBefore(textPos[Slot(firstId)]);
+        else
+            arena.Clear();
+    }
+
+    size_t slot = Slot(nextId++);
+
+    // Move the slot's bits from the entry it held (if any) to the new one
+    levelBits[(int)levels[slot]].ClearBit(slot);
+    if (tags[slot] < tagBits.size())
+        tagBits[tags[slot]].ClearBit(slot);
+    if (tagId >= tagBits.size()) {
+        size_t first = tagBits.size();
+        tagBits.resize((size_t)tagId + 1);
+        for (size_t i = first; i < tagBits.size(); i++)
+            tagBits[i].Resize(capacity);
+    }
+    levelBits[(int)level].SetBit(slot);
+    tagBits[tagId].SetBit(slot);
+
+    times[slot] = timeMs;
+    levels[slot] = level;
+    tags[slot] = tagId;
+    return slot;
+}
+
+uint64_t LogStore::Append(int64_t timeMs, LogLevel level, uint16_t tagId, std::string_view message) {
+    if (capacity == 0)
+        return nextId;
+
+    size_t slot = BeginAppend(timeMs, level, tagId);
+    textPos[slot] = arena.Append(message);
+    textLength[slot] = (uint32_t)message.size();
+    return nextId - 1;
+}
+
+uint64_t LogStore::AppendFormatV(int64_t timeMs, LogLevel level, uint16_t tagId, const char* fmt, va_list args) {
+    if (capacity == 0)
+        return nextId;
+
+    size_t slot = BeginAppend(timeMs, level, tagId);
+
+    // Try formatting into what's left of the current chunk first; only when the result
+    // doesn't fit do we reserve the exact size and format a second time
+    va_list copy;
+    va_copy(copy, args);
+    size_t space = arena.TailSpace();
+    int len = vsnprintf(space > 0 ? arena.Tail() : nullptr, space, fmt, copy);
+    va_end(copy);
+    if (len < 0)
+        len = 0;
+    if ((size_t)len >= space && len > 0)
+        vsnprintf(arena.Reserve((size_t)len + 1), (size_t)len + 1, fmt, args);
+
+    textPos[slot] = arena.Commit((size_t)len);
+    textLength[slot] = (uint32_t)len;
+    return nextId - 1;
+}
+
+void LogStore::Clear() {
+    firstId = nextId;
+    arena.Clear();
+    for (LogBitset& bits : levelBits)
+        bits.ClearAll();
+    for (LogBitset& bits : tagBits)
+        bits.ClearAll();
+}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "LogRecord.h"
+#include "LogArena.h"
+#include "LogBitset.h"
+#include <cstdarg>
+#include <string_view>
+#include <vector>
+
+namespace ClassGame {
+
+// In-memory log history kept as struct-of-arrays over a fixed-capacity ring.
+// Entries are addressed either by index (0 = oldest retained) or by id, which increases
+// monotonically for the life of the store and survives Clear(). Id N lives in slot N % capacity.
+// Per-level and per-tag bitsets over the slots track which live entries have each level/tag;
+// they are updated as entries are appended, evicted and cleared.
+class LogStore {
+public:
+    explicit LogStore(size_t capacity = 0) { SetCapacity(capacity); }
+
+    // Resize, keeping the newest entries that still fit
+    void SetCapacity(size_t capacity);
+    size_t Capacity() const { return capacity; }
+
+    // Returns the id of the new entry, evicting the oldest when full
+    uint64_t Append(int64_t timeMs, LogLevel level, uint16_t tagId, std::string_view message);
+    // Same, with the message printf-formatted directly into the text arena
+    uint64_t AppendFormatV(int64_t timeMs, LogLevel level, uint16_t tagId, const char* fmt, va_list args);
+    void Clear();
+
+    size_t Size() const { return (size_t)(nextId - firstId); }
+    bool Empty() const { return nextId == firstId; }
+    uint64_t FirstId() const { return firstId; }
+    uint64_t NextId() const { return nextId; }
+    size_t Slot(uint64_t id) const { return (size_t)(id % capacity); }
+
+    // Accessors by index, 0 = oldest
+    int64_t GetTime(size_t i) const { return times[Slot(firstId + i)]; }
+    LogLevel GetLevel(size_t i) const { return levels[Slot(firstId + i)]; }
+    uint16_t GetTag(size_t i) const { return tags[Slot(firstId + i)]; }
+    std::string_view GetMessage(size_t i) const {
+        size_t slot = Slot(firstId + i);
+        if (textLength[slot] == 0)
+            return std::string_view();
+        return std::string_view(arena.Get(textPos[slot]), textLength[slot]);
+    }
+
+    // Slot bitsets for the filters. A tag that was never stored has no bitset (nullptr).
+    const LogBitset& LevelBits(LogLevel level) const { return levelBits[(int)level]; }
+    const LogBitset* TagBits(uint16_t tagId) const { return tagId < tagBits.size() ? &tagBits[tagId] : nullptr; }
+
+    void SetTextChunkSize(size_t size) { arena.SetChunkSize(size); }
+    size_t TextBytes() const { return arena.BytesInUse(); }
+    size_t TextAllocations() const { return arena.Allocations(); }
+
+private:
+    size_t BeginAppend(int64_t timeMs, LogLevel level, uint16_t tagId);
+
+    size_t capacity = 0;
+    uint64_t firstId = 0;
+    uint64_t nextId = 0;
+
+    std::vector<int64_t> times;         // Milliseconds since epoch
+    std::vector<LogLevel> levels;
+    std::vector<uint16_t> tags;         // Interned tag id, 0 = no tag
+    std::vector<uint64_t> textPos;      // Message position in the arena
+    std::vector<uint32_t> textLength;
+    LogArena arena;
+    LogBitset levelBits[(int)LogLevel::Count];
+    std::vector<LogBitset> tagBits;     // Indexed by tag id
+};
+
+}
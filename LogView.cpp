@@ -0,0 +1,198 @@
+#include "LogView.h"
+#include "Logger.h"
+#include "LogFormat.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace ClassGame {
+
+bool LogView::IsTagVisible(uint16_t tagId) const {
+    return std::find(hiddenTags.begin(), hiddenTags.end(), tagId) == hiddenTags.end();
+}
+
+void LogView::SetTagVisible(uint16_t tagId, bool visible) {
+    auto it = std::find(hiddenTags.begin(), hiddenTags.end(), tagId);
+    if (visible && it != hiddenTags.end())
+        hiddenTags.erase(it);
+    else if (!visible && it == hiddenTags.end())
+        hiddenTags.push_back(tagId);
+    else
+        return;
+    tagsChanged = true;
+}
+
+// mask = (OR of the shown levels) AND NOT (each hidden tag). Level bits are only set for
+// live entries, so evicted and cleared slots drop out on their own.
+void LogView::RebuildWords(const LogStore& store, size_t firstWord, size_t lastWord) {
+    for (size_t w = firstWord; w < lastWord; w++) {
+        uint64_t bits = 0;
+        for (int level = 0; level < (int)LogLevel::Count; level++) {
+            if (appliedLevel[level])
+                bits |= store.LevelBits((LogLevel)level).Word(w);
+        }
+        for (uint16_t tagId : hiddenTags) {
+            if (const LogBitset* tagBits = store.TagBits(tagId))
+                bits &= ~tagBits->Word(w);
+        }
+        mask[w] = bits;
+    }
+}
+
+void LogView::SetSearch(std::string_view text) {
+    if (text == searchText)
+        return;
+    searchText.assign(text);
+    searchChanged = true;
+}
+
+LogView::MaskChange LogView::Refresh(const LogStore& store) {
+    size_t capacity = store.Capacity();
+    size_t words = (capacity + 63) / 64;
+
+    // Entries only leave by being overwritten, so anything else moving FirstId is a Clear
+    uint64_t expectedFirstId = knownFirstId;
+    if (store.NextId() - expectedFirstId > capacity)
+        expectedFirstId = store.NextId() - capacity;
+
+    size_t firstChanged;
+    MaskChange change = MaskChange::Appended;
+    if (tagsChanged || memcmp(appliedLevel, showLevel, sizeof(showLevel)) != 0 || capacity != knownCapacity ||
+        store.FirstId() != expectedFirstId || store.NextId() - scannedId >= capacity) {
+        memcpy(appliedLevel, showLevel, sizeof(showLevel));
+        tagsChanged = false;
+        knownCapacity = capacity;
+        mask.assign(words, 0);
+        prefix.assign(words + 1, 0);
+        RebuildWords(store, 0, words);
+        firstChanged = 0;
+        change = MaskChange::Rebuilt;
+    }
+    else if (scannedId < store.NextId()) {
+        // Only the words holding newly written slots changed; they may wrap past the end
+        size_t firstSlot = store.Slot(scannedId);
+        size_t lastSlot = store.Slot(store.NextId() - 1);
+        if (firstSlot <= lastSlot) {
+            RebuildWords(store, firstSlot / 64, lastSlot / 64 + 1);
+            firstChanged = firstSlot / 64;
+        }
+        else {
+            RebuildWords(store, firstSlot / 64, words);
+            RebuildWords(store, 0, lastSlot / 64 + 1);
+            firstChanged = 0;
+        }
+    }
+    else {
+        return MaskChange::None;
+    }
+
+    for (size_t w = firstChanged; w < words; w++)
+        prefix[w + 1] = prefix[w] + (uint32_t)std::popcount(mask[w]);
+    scannedId = store.NextId();
+    knownFirstId = store.FirstId();
+    return change;
+}
+
+// A new query, a filter change or a Clear reruns the search through the index. Otherwise the
+// matches only lose evicted ids at the front and gain the new entries that match, tested one
+// by one, so a steady stream of log lines costs nothing per frame beyond those lines.
+void LogView::RefreshSearch(const LogStore& store, MaskChange change) {
+    if (!IsSearching()) {
+        matches.clear();
+        return;
+    }
+    Logger& logger = Logger::GetInstance();
+    // A tag: that named no tag yet may name one now
+    if (query.unknownTag && logger.GetTagCount() != queryTagCount)
+        searchChanged = true;
+
+    if (searchChanged || change == MaskChange::Rebuilt) {
+        if (searchChanged) {
+            query = logger.ParseQuery(searchText);
+            queryTagCount = logger.GetTagCount();
+            searchChanged = false;
+        }
+        logger.Search(query, matches);
+        matches.erase(std::remove_if(matches.begin(), matches.end(), [&](uint64_t id) {
+            return !Visible(store.Slot(id));
+        }), matches.end());
+    }
+    else if (change == MaskChange::Appended) {
+        matches.erase(matches.begin(), std::lower_bound(matches.begin(), matches.end(), store.FirstId()));
+        size_t start = matches.size();
+        LogSearchIndex::ScanFrom(store, query, searchedId, matches);
+        matches.erase(std::remove_if(matches.begin() + start, matches.end(), [&](uint64_t id) {
+            return !Visible(store.Slot(id));
+        }), matches.end());
+    }
+    searchedId = store.NextId();
+}
+
+// Visible entries in slot order before this slot
+size_t LogView::Rank(size_t slot) const {
+    size_t w = slot / 64;
+    uint64_t below = ((uint64_t)1 << (slot % 64)) - 1;
+    return prefix[w] + (size_t)std::popcount(mask[w] & below);
+}
+
+// Slot of the row-th visible entry counting from the oldest (firstSlot); wraps like the ring
+size_t LogView::SelectRow(size_t row, size_t firstSlot) const {
+    size_t rank = Rank(firstSlot) + row;
+    if (rank >= prefix.back())
+        rank -= prefix.back();
+    size_t w = (size_t)(std::upper_bound(prefix.begin(), prefix.end(), (uint32_t)rank) - prefix.begin()) - 1;
+    return w * 64 + (size_t)LogBitset::SelectInWord(mask[w], (int)(rank - prefix[w]));
+}
+
+// The visible slot after this one, wrapping like the ring; there must be another one
+size_t LogView::NextVisible(size_t slot) const {
+    size_t w = slot / 64;
+    uint64_t bits = slot % 64 == 63 ? 0 : mask[w] & (~(uint64_t)0 << (slot % 64 + 1));
+    while (bits == 0) {
+        w = w + 1 == mask.size() ? 0 : w + 1;
+        bits = mask[w];
+    }
+    return w * 64 + (size_t)std::countr_zero(bits);
+}
+
+void LogView::Draw(const char* id, const ImVec2& size) {
+    Logger& logger = Logger::GetInstance();
+    const LogStore& store = logger.GetStore();
+    RefreshSearch(store, Refresh(store));
+
+    ImGui::BeginChild(id, size, true);
+
+    size_t capacity = store.Capacity();
+    size_t firstSlot = store.Slot(store.FirstId());
+    ImGuiListClipper clipper;
+    clipper.Begin((int)(IsSearching() ? matches.size() : VisibleCount()));
+    while (clipper.Step()) {
+        // Only the first row of each step is looked up by rank (a binary search over the word
+        // counts); the rest follow it in the mask, one bit scan each
+        size_t slot = 0;
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            size_t i;
+            if (IsSearching()) {
+                i = (size_t)(matches[row] - store.FirstId());
+            }
+            else {
+                slot = row == clipper.DisplayStart ? SelectRow((size_t)row, firstSlot) : NextVisible(slot);
+                i = (slot + capacity - firstSlot) % capacity;
+            }
+            LogLevel level = store.GetLevel(i);
+
+            FormatLogLine(line, store.GetTime(i), level, logger.GetTagName(store.GetTag(i)), store.GetMessage(i));
+            ImGui::PushStyleColor(ImGuiCol_Text, Logger::GetLevelColor(level));
+            ImGui::TextUnformatted(line.data(), line.data() + line.size());
+            ImGui::PopStyleColor();
+        }
+    }
+    clipper.End();
+
+    // Stick to the bottom while the user hasn't scrolled up
+    if (ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
+        ImGui::SetScrollHereY(1.0f);
+    ImGui::EndChild();
+}
+
+}
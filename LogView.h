@@ -0,0 +1,67 @@
+#pragma once
+
+#include "LogRecord.h"
+#include "LogSearch.h"
+#include "imgui/imgui.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ClassGame {
+
+class LogStore;
+
+// Scrolling body of the Game Log window. The set of entries passing the level/tag filters is
+// kept as a bitmask over the store's slots, built a word at a time from LogStore's level and
+// tag bitsets, with running popcounts per word so the clipper can jump straight to row N.
+// Only words whose slots changed are recomputed each frame; each frame formats and submits
+// just the rows ImGuiListClipper reports as visible. A non-empty search narrows the rows to
+// Logger::Search results that also pass the filters.
+class LogView {
+public:
+    bool showLevel[(int)LogLevel::Count] = { true, true, true };
+
+    bool IsTagVisible(uint16_t tagId) const;
+    void SetTagVisible(uint16_t tagId, bool visible);
+
+    // Search box text, see Logger::ParseQuery. Empty shows everything.
+    void SetSearch(std::string_view text);
+    bool IsSearching() const { return !searchText.empty(); }
+    size_t MatchCount() const { return matches.size(); }
+
+    // Draw inside a child region of the given size (ImGui::BeginChild semantics)
+    void Draw(const char* id, const ImVec2& size);
+
+    size_t VisibleCount() const { return prefix.empty() ? 0 : prefix.back(); }
+
+private:
+    // What Refresh did to the mask: nothing, new entries only, or rebuilt it from scratch
+    enum class MaskChange { None, Appended, Rebuilt };
+    MaskChange Refresh(const LogStore& store);
+    void RefreshSearch(const LogStore& store, MaskChange change);
+    bool Visible(size_t slot) const { return (mask[slot / 64] >> (slot % 64)) & 1; }
+    void RebuildWords(const LogStore& store, size_t firstWord, size_t lastWord);
+    size_t Rank(size_t slot) const;
+    size_t SelectRow(size_t row, size_t firstSlot) const;
+    size_t NextVisible(size_t slot) const;
+
+    std::vector<uint64_t> mask;         // Bit per store slot: live and passing the filters
+    std::vector<uint32_t> prefix;       // prefix[w] = set bits in mask words before w
+    uint64_t scannedId = 0;             // Every id below this is reflected in mask
+    uint64_t knownFirstId = 0;
+    size_t knownCapacity = 0;
+    bool appliedLevel[(int)LogLevel::Count] = { true, true, true };
+    std::vector<uint16_t> hiddenTags;
+    bool tagsChanged = false;
+    std::string line;                   // Reused row text
+
+    std::string searchText;
+    bool searchChanged = false;
+    LogQuery query;                     // searchText parsed
+    size_t queryTagCount = 0;           // Tags interned when it was parsed
+    uint64_t searchedId = 0;            // Every id below this has been tested against the query
+    std::vector<uint64_t> matches;      // Search hits passing the filters, oldest first
+};
+
+}
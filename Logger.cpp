@@ -1,102 +1,886 @@
 #include "Logger.h"
-#include <iomanip>
-#include <sstream>
+#include "LogFormat.h"
+#include <cstdio>
+#include <cstdarg>
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <iterator>
 
 namespace ClassGame {
 
+// Crash paths: flush what we have, then hand the signal to whatever handler was there before us
+static std::terminate_handler previousTerminate = nullptr;
+static const int crashSignals[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+#ifdef _WIN32
+static void (*previousHandlers[std::size(crashSignals)])(int) = {};
+#else
+static struct sigaction previousActions[std::size(crashSignals)];
+#endif
+
+// Put the previous handler back and raise again; the signal is blocked until we return, so it
+// then reaches that handler (or the default action) as if we had never been installed
+static void OnCrashSignal(int sig) {
+    Logger::GetInstance().CrashFlush();
+    for (size_t i = 0; i < std::size(crashSignals); i++) {
+        if (crashSignals[i] != sig)
+            continue;
+        #ifdef _WIN32
+        void (*previous)(int) = previousHandlers[i];
+        signal(sig, previous == SIG_IGN || previous == SIG_ERR || !previous ? SIG_DFL : previous);
+        #else
+        struct sigaction previous = previousActions[i];
+        if (!(previous.sa_flags & SA_SIGINFO) && previous.sa_handler == SIG_IGN)
+            previous.sa_handler = SIG_DFL;      // A fault can't be ignored, it would just repeat
+        sigaction(sig, &previous, nullptr);
+        #endif
+    }
+    raise(sig);
+}
+
+static void OnTerminate() {
+    Logger::GetInstance().CrashFlush();
+    if (previousTerminate)
+        previousTerminate();
+    abort();
+}
+
+static void InstallCrashHandlers() {
+    static bool installed = false;
+    if (installed) return;
+    installed = true;
+    
+    for (size_t i = 0; i < std::size(crashSignals); i++) {
+        #ifdef _WIN32
+        previousHandlers[i] = signal(crashSignals[i], OnCrashSignal);
+        #else
+        struct sigaction action = {};
+        action.sa_handler = OnCrashSignal;
+        action.sa_flags = SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+        sigaction(crashSignals[i], &action, &previousActions[i]);
+        #endif
+    }
+    previousTerminate = std::set_terminate(OnTerminate);
+}
+
+static int64_t NowMs() {
+    auto now = std::chrono::system_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+}
+
 // Logger initialization and system feedback
 void Logger::Init(const std::string& filename) {
-    if (initialized) return;
+    LoggerConfig cfg;
+    cfg.filename = filename;
+    Init(cfg);
+}
+
+void Logger::Init(const LoggerConfig& cfg) {
+    if (initialized.load(std::memory_order_relaxed)) return;
+    config = cfg;
+    stagingCapacity.store(config.stagingCapacity, std::memory_order_relaxed);
+    mainThread = std::this_thread::get_id();
     
-    logFile.open(filename, std::ios::app);
-    if (logFile.is_open()) {
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        
-        char timeStr[26];
-        ctime_s(timeStr, sizeof(timeStr), &time_t);
+    store.SetTextChunkSize(config.arenaChunkSize);
+    keepHistory = config.historyCapacity > 0;
+    store.SetCapacity(keepHistory ? config.historyCapacity : 1);
+    lineBuffer.reserve(512);
+    messageBuffer.reserve(keepHistory ? 0 : 512);
+    
+    bool fileOpen;
+    if (config.binaryLog) {
+        auto binary = std::make_unique<BinaryFileSink>();
+        std::string path = std::filesystem::path(config.filename).replace_extension(".bin").string();
+        fileOpen = binary->Open(path, config.fileBufferSize, config.flushPolicy, config.flushIntervalMs);
+        fileSink = std::move(binary);
+        binaryOutput = fileOpen;
+    }
+    else if (config.rotateLogs) {
+        auto rotating = std::make_unique<RotatingFileSink>();
+        if (config.compressSegments) {
+            archiver.Start();
+            rotating->onSegmentClosed = [this](const std::string& path) { archiver.Enqueue(path); };
+            rotating->onSegmentExpired = [this](const std::string& path) { archiver.EnqueueRemove(path); };
+        }
+        fileOpen = rotating->Open(config.filename, config.segmentSize, (int64_t)config.rotateIntervalMinutes * 60 * 1000,
+                                  config.maxSegments, config.flushPolicy, config.flushIntervalMs);
+        rotatingSink = rotating.get();
+        fileSink = std::move(rotating);
+    }
+    else {
+        auto file = std::make_unique<FileSink>();
+        fileOpen = file->Open(config.filename, config.fileBufferSize, config.flushPolicy, config.flushIntervalMs);
+        fileSink = std::move(file);
+    }
+    if (config.installCrashHandlers)
+        InstallCrashHandlers();
+    
+    // A ring still marked dirty means the last run died before any handler could dump it
+    size_t recovered = 0;
+    if (config.flightRecorder) {
+        std::filesystem::path base(config.filename);
+        std::string ringPath = std::filesystem::path(base).replace_extension(".flight").string();
+        crashDumpPath = std::filesystem::path(base).replace_extension(".crash.txt").string();
+        recovered = LogFlightRecorder::Recover(ringPath, crashDumpPath);
+        flightRecorder.Open(ringPath, config.flightRecorderEntries);
     }
     
-    initialized = true;
+    // Start the background writer; AddEntry only enqueues from here on
+    if (config.async && fileOpen) {
+        queue.Init(config.queueCapacity);
+        writerRunning.store(true, std::memory_order_release);
+        writer = std::thread(&Logger::WriterLoop, this);
+    }
+    
+    initialized.store(true, std::memory_order_release);
     Info("Game started successfully");
     Info("Application initialized", "GAME");
+    if (recovered > 0)
+        LogFormat(LogLevel::Warning, {}, "Previous run ended abruptly, its last %zu entries are in %s", recovered,
+                  crashDumpPath.c_str());
 }
 
-// Define entry pattern - timestamp, tag, and message
-// Outputs to Game Log Window, console, and game_log.txt (in Debug folder or local)
-void Logger::AddEntry(const std::string& level, const std::string& message, const std::string& tag, const ImVec4& color) {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()
-    ) % 1000;
-    
-    std::stringstream ss;
-    
-    std::tm tm;
-    localtime_s(&tm, &time_t);
-    
-    // Format: [HH:MM:SS.mmm]
-    ss << "["
-       << std::setfill('0') 
-       << std::setw(2) << tm.tm_hour << ":"
-       << std::setw(2) << tm.tm_min << ":"
-       << std::setw(2) << tm.tm_sec
-       << "." << std::setw(3) << ms.count()
-       << "] ";
+// Entries are stored as structured fields; the "[HH:MM:SS.mmm] [LEVEL] [TAG] msg" text is only
+// built when something needs it (Game Log window, console, game_log.txt in Debug folder or local)
+void Logger::AddEntry(LogLevel level, std::string_view message, std::string_view tag) {
+    if (!IsEnabled(level, tag))
+        return;
+    uint16_t tagId = InternTag(tag);
+    if (!OnMainThread()) {
+        Stage(level, tagId, message);
+        return;
+    }
     
-    // Add level: [INFO], [WARN], [ERROR]
-    ss << "[" << level << "] ";
+    BeginEntry();
+    int64_t timeMs = NowMs();
+    if (ToHistory(level, tagId))
+        store.Append(timeMs, level, tagId, message);
+    Output(timeMs, level, tagId, message);
+}
+
+void Logger::Log(LogLevel level, std::string_view message, std::string_view tag, LogSite& site) {
+    if (!IsEnabled(level, tag) || !PassSite(site, level, tag, message, true))
+        return;
+    AddEntry(level, message, tag);
+}
+
+static uint64_t HashEntry(LogLevel level, std::string_view tag, std::string_view content) {
+    uint64_t hash = 14695981039346656037ull ^ (uint64_t)level;
+    for (char c : tag)
+        hash = (hash ^ (unsigned char)c) * 1099511628211ull;
+    hash = (hash ^ 0xff) * 1099511628211ull;
+    for (char c : content)
+        hash = (hash ^ (unsigned char)c) * 1099511628211ull;
+    return hash;
+}
+
+// Storm control for a macro call site, false drops the entry. On the main thread an entry
+// identical to the previous entry (same site, tag and message or arguments) only bumps the
+// repeat count; everything else then has to get past the site's token bucket. An entry that
+// passes becomes the start of the next run once it is written, see BeginEntry.
+bool Logger::PassSite(LogSite& site, LogLevel level, std::string_view tag, std::string_view content,
+                      bool comparable) {
+    // The pending* fields belong to the main thread; other threads never touch them
+    bool collapse = config.collapseRepeats && OnMainThread();
+    if (collapse)
+        pendingSite = nullptr;
+    uint64_t hash = 0;
+    if (collapse && comparable) {
+        hash = HashEntry(level, tag, content);
+        if (&site == repeatSite && hash == repeatHash) {
+            if (repeatCount++ == 0)
+                repeatStartMs = NowMs();
+            collapsedRepeats++;
+            return false;
+        }
+    }
+    if (!Admit(site))
+        return false;
     
-    // Add tag ([GAME])
-    if (!tag.empty()) {
-        ss << "[" << tag << "] ";
+    if (collapse && comparable) {
+        pendingSite = &site;
+        pendingHash = hash;
+        pendingLevel = level;
+        pendingTagId = InternTag(tag);
     }
+    return true;
+}
+
+// Main thread, before anything is written for an entry: whatever it is (macro, direct call,
+// merged from another thread, command reply) it ends the current repeat run, whose count is
+// written out first. A macro entry PassSite just let through starts the next run.
+void Logger::BeginEntry() {
+    if (writingSummary)
+        return;
+    const LogSite* site = pendingSite;
+    pendingSite = nullptr;
+    FlushRepeats();
+    repeatSite = site;
+    repeatHash = pendingHash;
+    repeatLevel = pendingLevel;
+    repeatTagId = pendingTagId;
+}
+
+// Token bucket in thousandths of an entry: refilled at rateLimit per second up to rateBurst,
+// each entry takes a whole one. Racing threads may over- or under-refill slightly.
+bool Logger::Admit(LogSite& site) {
+    if (config.rateLimit <= 0)
+        return true;
     
-    // Add the actual message
-    ss << message;
+    int64_t now = NowMs();
+    int64_t last = site.refillMs.load(std::memory_order_relaxed);
+    if (now > last && site.refillMs.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+        int64_t cap = (int64_t)config.rateBurst * 1000;
+        int64_t add = (now - last) * config.rateLimit;    // A quiet site's first refill fills it
+        int64_t tokens = site.tokens.load(std::memory_order_relaxed);
+        while (!site.tokens.compare_exchange_weak(tokens, add < cap - tokens ? tokens + add : cap,
+                                                  std::memory_order_relaxed)) {}
+    }
     
-    std::string entry = ss.str();
-    entries.push_back(entry);
-    colors.push_back(color);
+    int64_t tokens = site.tokens.load(std::memory_order_relaxed);
+    do {
+        if (tokens < 1000) {
+            rateLimited.fetch_add(1, std::memory_order_relaxed);
+            if (site.suppressed.fetch_add(1, std::memory_order_relaxed) == 0) {
+                std::lock_guard<std::mutex> lock(suppressedMutex);
+                suppressedSites.push_back(&site);
+            }
+            return false;
+        }
+    } while (!site.tokens.compare_exchange_weak(tokens, tokens - 1000, std::memory_order_relaxed));
+    return true;
+}
+
+// Write out the pending repeat count; the summary line itself doesn't end the run
+void Logger::FlushRepeats() {
+    if (repeatCount == 0)
+        return;
+    uint32_t count = repeatCount;
+    repeatCount = 0;
+    writingSummary = true;
+    LogFormat(repeatLevel, tags[repeatTagId].name, "Last message repeated %u times", count);
+    writingSummary = false;
+}
+
+// Once per frame, one line per call site the rate limit held back
+void Logger::ReportSuppressed() {
+    {
+        std::lock_guard<std::mutex> lock(suppressedMutex);
+        if (suppressedSites.empty())
+            return;
+        reportSites.swap(suppressedSites);
+    }
+    for (LogSite* site : reportSites) {
+        uint32_t count = site->suppressed.exchange(0, std::memory_order_relaxed);
+        const char* file = site->file;
+        for (const char* p = file; *p; p++) {
+            if (*p == '/' || *p == '\\')
+                file = p + 1;
+        }
+        if (count > 0)
+            LogFormat(LogLevel::Warning, "LOG", "Rate limit dropped %u entries from %s:%d", count, file, site->line);
+    }
+    reportSites.clear();
+}
+
+void Logger::LogFormat(LogLevel level, std::string_view tag, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    LogFormatV(level, tag, fmt, args);
+    va_end(args);
+}
+
+// LogArgs forwards here; the format was already checked at the macro call site
+void Logger::LogFormatUnchecked(LogLevel level, std::string_view tag, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    LogFormatV(level, tag, fmt, args);
+    va_end(args);
+}
+
+void Logger::LogFormatV(LogLevel level, std::string_view tag, const char* fmt, va_list args) {
+    if (!IsEnabled(level, tag))
+        return;
+    uint16_t tagId = InternTag(tag);
+    if (!OnMainThread()) {
+        thread_local std::string text;
+        va_list retry;
+        va_copy(retry, args);
+        int length = vsnprintf(nullptr, 0, fmt, args);
+        text.resize(length > 0 ? (size_t)length : 0);
+        vsnprintf(&text[0], text.size() + 1, fmt, retry);
+        va_end(retry);
+        Stage(level, tagId, text);
+        return;
+    }
     
-    if (entries.size() > 1000) {
-        entries.erase(entries.begin());
-        colors.erase(colors.begin());
+    BeginEntry();
+    int64_t timeMs = NowMs();
+    if (ToHistory(level, tagId)) {
+        // The formatted text lives in the arena, hand that same view to the outputs
+        store.AppendFormatV(timeMs, level, tagId, fmt, args);
+        Output(timeMs, level, tagId, store.GetMessage(store.Size() - 1));
+        return;
+    }
+    Output(timeMs, level, tagId, FormatMessageV(fmt, args));
+}
+
+void Logger::Reply(LogLevel level, const char* fmt, ...) {
+    BeginEntry();
+    uint16_t tagId = InternTag("CMD");
+    int64_t timeMs = NowMs();
+    va_list args;
+    va_start(args, fmt);
+    if (keepHistory) {
+        store.AppendFormatV(timeMs, level, tagId, fmt, args);
+        Output(timeMs, level, tagId, store.GetMessage(store.Size() - 1));
+    }
+    else {
+        Output(timeMs, level, tagId, FormatMessageV(fmt, args));
     }
+    va_end(args);
+}
+
+// Main thread, for entries the history doesn't keep: formats into the reused messageBuffer
+std::string_view Logger::FormatMessageV(const char* fmt, va_list args) {
+    size_t capacity = messageBuffer.capacity();
+    messageBuffer.resize(capacity);
+    va_list retry;
+    va_copy(retry, args);
+    int length = vsnprintf(&messageBuffer[0], capacity + 1, fmt, args);
+    if (length > (int)capacity) {
+        messageBuffer.resize((size_t)length);
+        vsnprintf(&messageBuffer[0], (size_t)length + 1, fmt, retry);
+    }
+    va_end(retry);
+    messageBuffer.resize(length > 0 ? (size_t)length : 0);
+    messageBufferGrowths += messageBuffer.capacity() != capacity;
+    return messageBuffer;
+}
+
+// History copy of a binary-logged entry
+void Logger::AppendHistory(int64_t timeMs, LogLevel level, uint16_t tagId, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    store.AppendFormatV(timeMs, level, tagId, fmt, args);
+    va_end(args);
+}
+
+int64_t Logger::OutputEncoded(LogLevel level, uint16_t tagId, const char* format, std::string_view args) {
+    int64_t timeMs = NowMs();
+    Output(timeMs, level, tagId, args, format);
+    return timeMs;
+}
+
+void Logger::Output(int64_t timeMs, LogLevel level, uint16_t tagId, std::string_view message,
+                    const char* format, bool recorded) {
+    const std::string& tag = tags[tagId].name;
     
-    // Write to file
-    if (logFile.is_open()) {
-        logFile << entry << "\n";
-        logFile.flush();
+    // Write to file - queued for the writer thread in async mode
+    bool toFile = Routed(level, tagId, LogRoute::File);
+    if (toFile && !recorded)
+        RecordFlight(timeMs, level, tagId, message, format);
+    if (toFile && writerRunning.load(std::memory_order_acquire)) {
+        PushToWriter(timeMs, level, tagId, message, format);
+    }
+    else if (toFile && fileSink) {
+        if (format)
+            fileSink->WriteEncoded(timeMs, level, tag, format, message.data(), message.size());
+        else
+            fileSink->Write(timeMs, level, tag, message);
+        fileSink->Poll(timeMs);
     }
     
     // Also print to console
     #ifdef _DEBUG
-    printf("%s\n", entry.c_str());
+    if (!Routed(level, tagId, LogRoute::Console))
+        return;
+    size_t capacity = lineBuffer.capacity();
+    if (format) {
+        thread_local std::string decoded;
+        LogBinary::FormatArgs(decoded, format, message.data(), message.size());
+        FormatLogLine(lineBuffer, timeMs, level, tag, decoded);
+    }
+    else {
+        FormatLogLine(lineBuffer, timeMs, level, tag, message);
+    }
+    lineBufferGrowths += lineBuffer.capacity() != capacity;
+    printf("%s\n", lineBuffer.c_str());
+    #endif
+}
+
+void Logger::PushToWriter(int64_t timeMs, LogLevel level, uint16_t tagId, std::string_view message,
+                          const char* format) {
+    while (!queue.TryPush(level, timeMs, tagId, message, format)) {
+        // Ring full: nudge the writer and retry rather than dropping the line
+        queueStalls.fetch_add(1, std::memory_order_relaxed);
+        writerWake.notify_one();
+        std::this_thread::yield();
+    }
+    // Don't wake the writer per line, it batches on its flush interval.
+    // Errors and a filling ring get written out right away.
+    if (writerIdle.load(std::memory_order_relaxed) &&
+        (level == LogLevel::Error || queue.ApproxSize() > queue.Capacity() / 2)) {
+        writerWake.notify_one();
+    }
+}
+
+// Other threads: copy the entry into this thread's ring for the next EndFrame (a full ring
+// spills to a locked list, see LogStaging). Entries routed only to the file go straight to
+// the writer queue, which is safe from any thread. Without a ring, before Init or after
+// Shutdown, an entry is dropped from the history.
+void Logger::Stage(LogLevel level, uint16_t tagId, std::string_view message, const char* format) {
+    int64_t timeMs = NowMs();
+    bool toFile = Routed(level, tagId, LogRoute::File);
+    bool toWriter = writerRunning.load(std::memory_order_acquire) && toFile;
+    bool merge = ToHistory(level, tagId);
+    #ifdef _DEBUG
+    merge = merge || Routed(level, tagId, LogRoute::Console);
     #endif
+    // Recorded now rather than at the merge, so a hard kill doesn't lose what's still staged
+    if (toFile)
+        RecordFlight(timeMs, level, tagId, message, format);
+    if (toWriter && !merge) {
+        PushToWriter(timeMs, level, tagId, message, format);
+        return;
+    }
+    
+    if (LogStaging* staging = ThreadStaging()) {
+        staging->Push(level, timeMs, tagId, message, format);
+        return;
+    }
+    stagingDrops.fetch_add(1, std::memory_order_relaxed);
+    if (toWriter)
+        PushToWriter(timeMs, level, tagId, message, format);
+}
+
+// Any thread. Encoded entries are formatted here since the ring only holds text.
+void Logger::RecordFlight(int64_t timeMs, LogLevel level, uint16_t tagId, std::string_view message,
+                          const char* format) {
+    if (!flightRecorder.IsOpen())
+        return;
+    if (format) {
+        thread_local std::string decoded;
+        LogBinary::FormatArgs(decoded, format, message.data(), message.size());
+        flightRecorder.Record(timeMs, level, tags[tagId].name, decoded);
+    }
+    else {
+        flightRecorder.Record(timeMs, level, tags[tagId].name, message);
+    }
+}
+
+// Each producer thread gets one ring, registered on its first entry and marked retired when
+// the thread exits so EndFrame can free it once drained. The thread shares ownership of its
+// ring, so a thread that outlives the Logger still has a ring to mark.
+LogStaging* Logger::ThreadStaging() {
+    struct StagingHandle {
+        std::shared_ptr<LogStaging> buffer;
+        ~StagingHandle() {
+            if (buffer)
+                buffer->retired.store(true, std::memory_order_release);
+        }
+    };
+    static thread_local StagingHandle handle;
+    if (!initialized.load(std::memory_order_acquire))
+        return nullptr;
+    if (!handle.buffer) {
+        handle.buffer = std::make_shared<LogStaging>(stagingCapacity.load(std::memory_order_relaxed));
+        std::lock_guard<std::mutex> lock(stagingMutex);
+        stagingBuffers.push_back(handle.buffer);
+    }
+    return handle.buffer.get();
+}
+
+// Main thread: move everything staged so far into the history and outputs, oldest first
+// across threads. Entries pushed while merging wait for the next frame.
+void Logger::MergeStaged() {
+    std::lock_guard<std::mutex> lock(stagingMutex);
+    if (stagingBuffers.empty())
+        return;
+    
+    stagingPending.resize(stagingBuffers.size());
+    for (size_t i = 0; i < stagingBuffers.size(); i++)
+        stagingPending[i] = stagingBuffers[i]->ApproxSize();
+    for (;;) {
+        size_t oldest = stagingBuffers.size();
+        for (size_t i = 0; i < stagingBuffers.size(); i++) {
+            if (stagingPending[i] == 0)
+                continue;
+            if (oldest == stagingBuffers.size() ||
+                stagingBuffers[i]->Front()->timeMs < stagingBuffers[oldest]->Front()->timeMs)
+                oldest = i;
+        }
+        if (oldest == stagingBuffers.size())
+            break;
+        MergeRecord(*stagingBuffers[oldest]->Front());
+        stagingBuffers[oldest]->Pop();
+        stagingPending[oldest]--;
+    }
+    
+    // Free the rings of threads that have exited
+    for (size_t i = 0; i < stagingBuffers.size();) {
+        LogStaging& staging = *stagingBuffers[i];
+        if (staging.retired.load(std::memory_order_acquire) && staging.Front() == nullptr) {
+            retiredStagingAllocations += staging.OverflowAllocations();
+            stagingBuffers.erase(stagingBuffers.begin() + i);
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+void Logger::MergeRecord(const LogRecord& rec) {
+    BeginEntry();
+    std::string_view message(rec.Message(), rec.messageLength);
+    if (ToHistory(rec.level, rec.tagId)) {
+        if (rec.format) {
+            size_t capacity = messageBuffer.capacity();
+            LogBinary::FormatArgs(messageBuffer, rec.format, message.data(), message.size());
+            messageBufferGrowths += messageBuffer.capacity() != capacity;
+            store.Append(rec.timeMs, rec.level, rec.tagId, messageBuffer);
+        }
+        else {
+            store.Append(rec.timeMs, rec.level, rec.tagId, message);
+        }
+    }
+    Output(rec.timeMs, rec.level, rec.tagId, message, rec.format, true);
+}
+
+size_t Logger::GetHeapAllocations() const {
+    size_t staging = retiredStagingAllocations;
+    {
+        std::lock_guard<std::mutex> lock(stagingMutex);
+        for (const auto& buffer : stagingBuffers)
+            staging += buffer->OverflowAllocations();
+    }
+    return store.TextAllocations() + queue.OverflowAllocations() + lineBufferGrowths + messageBufferGrowths +
+           staging + (fileSink ? fileSink->Allocations() : 0);
+}
+
+bool Logger::IsActiveLogFile(const std::string& path) const {
+    int active = rotatingSink ? rotatingSink->ActiveSegment() : 0;
+    if (active == 0)
+        return false;
+    std::error_code error;
+    return std::filesystem::equivalent(path, rotatingSink->SegmentPath(active), error);
+}
+
+static size_t HashTag(std::string_view tag) {
+    uint32_t hash = 2166136261u;
+    for (char c : tag)
+        hash = (hash ^ (unsigned char)c) * 16777619u;
+    return hash;
+}
+
+// Tags are few and long-lived, store each name once and refer to it by index. Any thread may
+// add one; the name is written before its hash slot publishes it.
+uint16_t Logger::InternTag(std::string_view tag) {
+    int id = FindTag(tag);
+    if (id >= 0)
+        return (uint16_t)id;
+    
+    {
+        std::lock_guard<std::mutex> lock(tagMutex);
+        id = FindTag(tag);     // Another thread may have added it since
+        if (id >= 0)
+            return (uint16_t)id;
+        size_t count = tagCount.load(std::memory_order_relaxed);
+        if (count < MaxTags) {
+            TagInfo& info = tags[count];
+            info.name.assign(tag);
+            info.threshold.store((uint8_t)minLevel.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            tagCount.store(count + 1, std::memory_order_release);
+            size_t slot = HashTag(tag) & (TagSlots - 1);
+            while (tagSlots[slot].load(std::memory_order_relaxed) != 0)
+                slot = (slot + 1) & (TagSlots - 1);
+            tagSlots[slot].store((uint16_t)count, std::memory_order_release);
+            return (uint16_t)count;
+        }
+        if (tagsFull.exchange(true, std::memory_order_relaxed))
+            return 0;
+    }
+    // Said once, outside the lock since logging it interns no tag
+    LogFormat(LogLevel::Warning, {}, "Tag table full (%zu tags): [%.*s] and later new tags are logged untagged",
+              MaxTags, (int)tag.size(), tag.data());
+    return 0;
+}
+
+// Open addressing over tagSlots, which is never more than half full
+int Logger::FindTag(std::string_view tag) const {
+    if (tag.empty())
+        return 0;
+    for (size_t slot = HashTag(tag) & (TagSlots - 1);; slot = (slot + 1) & (TagSlots - 1)) {
+        uint16_t id = tagSlots[slot].load(std::memory_order_acquire);
+        if (id == 0)
+            return -1;
+        if (tags[id].name == tag)
+            return id;
+    }
+}
+
+void Logger::SetMinLevel(LogLevel level) {
+    minLevel.store(level, std::memory_order_relaxed);
+    UpdateThresholdBounds();
+}
+
+void Logger::SetTagLevel(std::string_view tag, LogLevel level) {
+    tags[InternTag(tag)].level.store((int8_t)level, std::memory_order_relaxed);
+    UpdateThresholdBounds();
+}
+
+void Logger::ClearTagLevel(std::string_view tag) {
+    int id = FindTag(tag);
+    if (id >= 0) {
+        tags[id].level.store(-1, std::memory_order_relaxed);
+        UpdateThresholdBounds();
+    }
+}
+
+LogLevel Logger::GetTagLevel(std::string_view tag) const {
+    int id = FindTag(tag);
+    int8_t level = id < 0 ? -1 : tags[id].level.load(std::memory_order_relaxed);
+    return level < 0 ? minLevel.load(std::memory_order_relaxed) : (LogLevel)level;
+}
+
+void Logger::SetTagRoute(std::string_view tag, LogRoute route, LogLevel level) {
+    tags[InternTag(tag)].routeLevel[(int)route].store((uint8_t)level, std::memory_order_relaxed);
+    UpdateThresholdBounds();
+}
+
+LogLevel Logger::GetTagRoute(std::string_view tag, LogRoute route) const {
+    int id = FindTag(tag);
+    return id < 0 ? LogLevel::Info : (LogLevel)tags[id].routeLevel[(int)route].load(std::memory_order_relaxed);
 }
 
-void Logger::Info(const std::string& message, const std::string& tag) {
-    AddEntry("INFO", message, tag, ImVec4(1.0f, 1.0f, 1.0f, 1.0f)); // White
+LogLevel Logger::TagThreshold(std::string_view tag) const {
+    int id = FindTag(tag);
+    if (id < 0)
+        return minLevel.load(std::memory_order_relaxed);
+    return (LogLevel)tags[id].threshold.load(std::memory_order_relaxed);
 }
 
-void Logger::Warning(const std::string& message, const std::string& tag) {
-    AddEntry("WARN", message, tag, ImVec4(1.0f, 1.0f, 0.0f, 1.0f)); // Yellow
+// A tag's threshold is the stricter of its level and its most permissive route. IsEnabled
+// answers most calls from the min/max over all of them without looking the tag up.
+void Logger::UpdateThresholdBounds() {
+    std::lock_guard<std::mutex> lock(tagMutex);
+    LogLevel global = minLevel.load(std::memory_order_relaxed);
+    LogLevel lowest = global;
+    LogLevel highest = global;
+    size_t count = tagCount.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < count; i++) {
+        TagInfo& info = tags[i];
+        int8_t tagLevel = info.level.load(std::memory_order_relaxed);
+        LogLevel level = tagLevel < 0 ? global : (LogLevel)tagLevel;
+        LogLevel route = LogLevel::Count;
+        for (auto& routeLevel : info.routeLevel) {
+            if ((LogLevel)routeLevel.load(std::memory_order_relaxed) < route)
+                route = (LogLevel)routeLevel.load(std::memory_order_relaxed);
+        }
+        LogLevel threshold = level > route ? level : route;
+        info.threshold.store((uint8_t)threshold, std::memory_order_relaxed);
+        if (threshold < lowest) lowest = threshold;
+        if (threshold > highest) highest = threshold;
+    }
+    lowestThreshold.store(lowest, std::memory_order_relaxed);
+    highestThreshold.store(highest, std::memory_order_relaxed);
+}
+
+ImVec4 Logger::GetLevelColor(LogLevel level) {
+    switch (level) {
+        case LogLevel::Warning: return ImVec4(1.0f, 1.0f, 0.0f, 1.0f); // Yellow
+        case LogLevel::Error:   return ImVec4(1.0f, 0.0f, 0.0f, 1.0f); // Red
+        default:                return ImVec4(1.0f, 1.0f, 1.0f, 1.0f); // White
+    }
+}
+
+void Logger::Info(std::string_view message, std::string_view tag) {
+    AddEntry(LogLevel::Info, message, tag);
 }
 
-void Logger::Error(const std::string& message, const std::string& tag) {
-    AddEntry("ERROR", message, tag, ImVec4(1.0f, 0.0f, 0.0f, 1.0f)); // Red
+void Logger::Warning(std::string_view message, std::string_view tag) {
+    AddEntry(LogLevel::Warning, message, tag);
+}
+
+void Logger::Error(std::string_view message, std::string_view tag) {
+    AddEntry(LogLevel::Error, message, tag);
 }
 
 // Specific way to assign or add tags and take priority of the first tag's color
-void Logger::GameEvent(const std::string& message) {
-    AddEntry("INFO", message, "GAME", ImVec4(1.0f, 1.0f, 1.0f, 1.0f)); // White with [GAME] tag
+void Logger::GameEvent(std::string_view message) {
+    AddEntry(LogLevel::Info, message, "GAME"); // [GAME] tag
 }
 
 void Logger::Clear() {
-    entries.clear();
-    colors.clear();
+    store.Clear();
+    searchIndex.Clear();
 }
 
-}
\ No newline at end of file
+LogQuery Logger::ParseQuery(std::string_view text) const {
+    LogQuery query;
+    auto hasPrefix = [](std::string_view word, std::string_view prefix) {
+        if (word.size() < prefix.size())
+            return false;
+        for (size_t i = 0; i < prefix.size(); i++) {
+            if (tolower((unsigned char)word[i]) != prefix[i])
+                return false;
+        }
+        return true;
+    };
+    
+    while (!text.empty()) {
+        size_t start = text.find_first_not_of(' ');
+        if (start == std::string_view::npos)
+            break;
+        text.remove_prefix(start);
+        size_t end = text.find(' ');
+        std::string_view word = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end);
+        
+        LogLevel level;
+        if (hasPrefix(word, "tag:") && word.size() > 4) {
+            // Tags match regardless of case
+            std::string_view name = word.substr(4);
+            query.unknownTag = true;
+            for (size_t id = 1; id < GetTagCount(); id++) {
+                const std::string& tag = tags[id].name;
+                if (tag.size() == name.size() && std::equal(tag.begin(), tag.end(), name.begin(),
+                        [](char a, char b) { return tolower((unsigned char)a) == tolower((unsigned char)b); })) {
+                    query.tagId = (int)id;
+                    query.unknownTag = false;
+                    break;
+                }
+            }
+        }
+        else if (hasPrefix(word, "level:") && ParseLevelName(word.substr(6), level) && level != LogLevel::Count) {
+            query.level = (int)level;
+        }
+        else {
+            if (!query.text.empty())
+                query.text += ' ';
+            query.text.append(word);
+        }
+    }
+    return query;
+}
+
+void Logger::Search(const LogQuery& query, std::vector<uint64_t>& ids) {
+    if (config.searchIndex) {
+        searchIndex.Update(store);
+        searchIndex.Search(store, query, ids);
+    }
+    else {
+        LogSearchIndex::Scan(store, query, ids);
+    }
+}
+
+void Logger::EndFrame() {
+    MergeStaged();
+    if (repeatCount > 0 && NowMs() - repeatStartMs >= config.repeatSummaryMs)
+        FlushRepeats();
+    ReportSuppressed();
+    if (config.searchIndex)
+        searchIndex.Update(store);
+    
+    if (writerRunning.load(std::memory_order_acquire)) {
+        if (config.flushPolicy == FlushPolicy::EveryFrame) {
+            frameFlushRequested.store(true, std::memory_order_release);
+            writerWake.notify_one();
+        }
+    }
+    else if (fileSink) {
+        fileSink->OnFrameEnd();
+        fileSink->Poll(NowMs());
+    }
+}
+
+// Format every queued record into the file sink (writer thread, or a crash handler)
+void Logger::WriteQueued() {
+    while (LogRecord* rec = queue.Front()) {
+        const std::string& tag = tags[rec->tagId].name;
+        if (rec->format)
+            fileSink->WriteEncoded(rec->timeMs, rec->level, tag, rec->format, rec->Message(), rec->messageLength);
+        else
+            fileSink->Write(rec->timeMs, rec->level, tag, std::string_view(rec->Message(), rec->messageLength));
+        queue.Pop();
+    }
+}
+
+// Background writer - drains the ring into the file sink's buffer; the sink's flush policy
+// decides when that buffer reaches the OS. Sleeps until the next Interval flush is due.
+void Logger::WriterLoop() {
+    const int64_t interval = config.flushIntervalMs;
+    
+    for (;;) {
+        bool stopping = !writerRunning.load(std::memory_order_acquire);
+        if (crashing.load(std::memory_order_acquire))
+            return;
+        
+        WriteQueued();
+        if (frameFlushRequested.exchange(false, std::memory_order_acq_rel))
+            fileSink->OnFrameEnd();
+        int64_t now = NowMs();
+        fileSink->Poll(now);
+        
+        if (stopping && queue.Front() == nullptr) {
+            fileSink->Flush();
+            break;
+        }
+        
+        if (queue.Front() == nullptr) {
+            int64_t oldest = fileSink->OldestPendingMs();
+            int64_t wait = interval;
+            if (oldest >= 0 && config.flushPolicy == FlushPolicy::Interval)
+                wait = oldest + interval - now > 1 ? oldest + interval - now : 1;
+            
+            std::unique_lock<std::mutex> lock(writerMutex);
+            writerIdle.store(true, std::memory_order_relaxed);
+            writerWake.wait_for(lock, std::chrono::milliseconds(wait));
+            writerIdle.store(false, std::memory_order_relaxed);
+        }
+    }
+}
+
+void Logger::Shutdown() {
+    if (!initialized.load(std::memory_order_relaxed)) return;
+    
+    // Other threads stop staging first, so the merge below catches everything they staged
+    initialized.store(false, std::memory_order_release);
+    MergeStaged();
+    FlushRepeats();
+    ReportSuppressed();
+    if (writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            writerRunning.store(false, std::memory_order_release);
+        }
+        writerWake.notify_one();
+        writer.join();
+    }
+    
+    rotatingSink = nullptr;
+    fileSink.reset();
+    archiver.Stop();
+    flightRecorder.Close();
+}
+
+// Runs on whatever thread crashed, usually inside a signal handler, so it only does what is
+// async-signal-safe: the flight recorder is dumped next to the log, and the sink writes out
+// bytes it already formatted with raw write() calls. Records still in the writer queue or the
+// staging rings would need formatting and a second consumer, so they are left alone (the
+// flight recorder, when on, has copies of them). Only the first call does work.
+void Logger::CrashFlush() {
+    if (crashing.exchange(true, std::memory_order_acq_rel))
+        return;
+    
+    // First, since it needs nothing else to have worked and holds the most
+    flightRecorder.Dump(crashDumpPath.c_str());
+    if (fileSink)
+        fileSink->CrashFlush();
+}
+
+}
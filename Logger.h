@@ -1,13 +1,92 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <fstream>
 #include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <cstdarg>
 #include "imgui/imgui.h"
+#include "LogQueue.h"
+#include "LogStore.h"
+#include "LogSinks.h"
+#include "LogBinary.h"
+#include "LogSearch.h"
+#include "LogStaging.h"
+#include "LogFlightRecorder.h"
+#include "LogArchiver.h"
 
 namespace ClassGame {
 
+// Destinations an entry can reach. Each tag has a minimum level per route (SetTagRoute), so a
+// high-volume tag can go to the file without filling the Game Log window, or the other way round.
+enum class LogRoute : uint8_t {
+    File = 0,       // Whichever file sink the config picked: text, rotating or binary
+    Console,        // stdout, Debug builds only
+    History,        // In-memory ring behind the Game Log window and search
+    Count
+};
+
+struct LoggerConfig {
+    std::string filename = "game_log.txt";
+    bool async = true;              // Hand file output to a background writer thread
+    size_t queueCapacity = 4096;    // Record slots in the async ring (rounded up to a power of two)
+    size_t fileBufferSize = 64 * 1024;  // game_log.txt is written in blocks of up to this size
+    FlushPolicy flushPolicy = FlushPolicy::Interval;
+    int flushIntervalMs = 100;      // Interval policy: upper bound on how long a line waits before hitting disk
+    bool installCrashHandlers = true;   // Flush buffered lines on fatal signals / std::terminate
+    
+    // Rotation: write numbered memory-mapped segments (game_log.0001.txt, ...) instead of one growing file
+    bool rotateLogs = false;
+    size_t segmentSize = 8 * 1024 * 1024;   // Preallocated size of each segment
+    int rotateIntervalMinutes = 0;          // Also roll on wall-clock boundaries, 0 = size only
+    int maxSegments = 10;                   // Older segments are deleted
+    bool compressSegments = false;          // Finished segments become game_log.0001.txt.glz on a background thread
+    
+    // Binary: write game_log.bin (LogBinary records, turned back into text by log_decode) instead
+    // of the text file. LOG_*F calls then store raw arguments and skip formatting for the file.
+    // Takes precedence over rotateLogs.
+    bool binaryLog = false;
+    size_t historyCapacity = 1000;  // Entries kept in memory for the Game Log window, 0 = none
+    bool searchIndex = true;        // Keep a trigram index of the history for the search box
+    size_t arenaChunkSize = 64 * 1024; // Message text is stored in recycled chunks of this size
+    size_t stagingCapacity = 1024;  // Per-thread ring for entries logged off the main thread
+    
+    // Storm control for the LOG_* macros; direct Info/Warning/Error calls are never held back,
+    // but any entry ends a run of repeats
+    bool collapseRepeats = true;    // Identical consecutive entries from one call site become "Last message repeated N times"
+    int repeatSummaryMs = 1000;     // While a run lasts, its count is written out this often
+    int rateLimit = 200;            // Entries per second each call site may log, 0 = unlimited
+    int rateBurst = 400;            // Entries a quiet call site may log at once before the rate applies
+    
+    // Flight recorder: copy every file-bound entry into a memory-mapped ring (game_log.flight)
+    // that survives the process dying. A crash dumps it to game_log.crash.txt; after a hard
+    // kill the next Init does. With it on, a lazy flushPolicy no longer risks the last lines.
+    bool flightRecorder = false;
+    size_t flightRecorderEntries = 4096;    // 256 bytes each
+};
+
+// State the LOG_* macros keep per call site (a function-local static), so storm control finds
+// it by address instead of hashing the message or the source location
+struct LogSite {
+    constexpr LogSite(const char* sourceFile, int sourceLine) : file(sourceFile), line(sourceLine) {}
+    
+    const char* file;
+    int line;
+    std::atomic<int64_t> refillMs{ 0 };        // Token bucket, in thousandths of an entry
+    std::atomic<int64_t> tokens{ 0 };
+    std::atomic<uint32_t> suppressed{ 0 };      // Dropped since the last report
+};
+
+// Threading: the thread that calls Init is the main thread. It owns the history and the file
+// sink, and is the only one that may call Init/EndFrame/Shutdown, the threshold and route
+// setters or the UI accessors. Any thread may log: other threads copy entries into their own
+// LogStaging ring without locking, and EndFrame merges those rings into the history in
+// timestamp order. Tags are interned into a fixed table that any thread can add to.
 class Logger {
 public:
     static Logger& GetInstance() {
@@ -16,37 +95,301 @@ public:
     }
     
     // Initialize
-    void Init(const std::string& filename = "game_log.txt");
+    void Init(const LoggerConfig& config = LoggerConfig());
+    void Init(const std::string& filename);
+    
+    // Drain pending records, stop the writer thread and close the file
+    void Shutdown();
+    
+    // Call once per frame; drives the EveryFrame/Interval flush policies
+    void EndFrame();
+    
+    // Crash paths: writes out what the file sink already formatted and dumps the flight
+    // recorder, using only async-signal-safe calls. Queued and staged records are not written.
+    void CrashFlush();
     
     // Logging functions
-    void Info(const std::string& message, const std::string& tag = "");
-    void Warning(const std::string& message, const std::string& tag = "");
-    void Error(const std::string& message, const std::string& tag = "");
-    void GameEvent(const std::string& message);
-    
-    // UI display
-    const std::vector<std::string>& GetEntries() const { return entries; }
-    const std::vector<ImVec4>& GetColors() const { return colors; }
+    void Info(std::string_view message, std::string_view tag = {});
+    void Warning(std::string_view message, std::string_view tag = {});
+    void Error(std::string_view message, std::string_view tag = {});
+    void GameEvent(std::string_view message);
+    
+    // What LOG_INFO/LOG_WARN/LOG_ERROR call: AddEntry plus storm control for the call site
+    void Log(LogLevel level, std::string_view message, std::string_view tag, LogSite& site);
+    
+    // printf-style entry point behind the LOG_*F macros. The format is checked at compile
+    // time (GCC/Clang) and expanded straight into the history arena.
+    void LogFormat(LogLevel level, std::string_view tag, const char* fmt, ...) IM_FMTARGS(4);
+    
+    // Console command responses (HELP, listings, usage errors), tagged CMD. Main thread only.
+    // Skips thresholds and storm control and always reaches the history, so a reply shows up
+    // however the levels are set; it is never compiled out. File and console follow CMD's routes.
+    void Reply(LogLevel level, const char* fmt, ...) IM_FMTARGS(3);
+    
+    // What the LOG_*F macros actually call (after checking the format against LogFormatCheck).
+    // With binaryLog the arguments are copied out raw and fmt, a string literal (the macros
+    // enforce it), is written to the file by id; text is only formatted for the in-memory
+    // history.
+    // The encoded arguments also let repeats be spotted without formatting anything.
+    template<typename... Args>
+    void LogArgs(LogSite& site, LogLevel level, std::string_view tag, const char* fmt, const Args&... args) {
+        char encoded[LogRecord::InlineSize];
+        size_t length = LogBinary::EncodeArgs(encoded, sizeof(encoded), fmt, args...);
+        bool comparable = length != LogBinary::EncodeFailed;
+        if (!PassSite(site, level, tag, std::string_view(encoded, comparable ? length : 0), comparable))
+            return;
+        if (!binaryOutput || !comparable) {
+            // Text output, or too big to stage as binary: formatted as a plain message
+            LogFormatUnchecked(level, tag, fmt, args...);
+            return;
+        }
+        if (!IsEnabled(level, tag))
+            return;
+        uint16_t tagId = InternTag(tag);
+        if (!OnMainThread()) {
+            Stage(level, tagId, std::string_view(encoded, length), fmt);
+            return;
+        }
+        BeginEntry();
+        int64_t timeMs = OutputEncoded(level, tagId, fmt, std::string_view(encoded, length));
+        if (ToHistory(level, tagId))
+            AppendHistory(timeMs, level, tagId, fmt, args...);
+    }
+    
+    // Cheap pre-check the macros use so filtered calls never evaluate their arguments.
+    // Only falls through to the per-tag table when the level sits between tag overrides.
+    bool IsEnabled(LogLevel level, std::string_view tag = {}) const {
+        if (level < lowestThreshold.load(std::memory_order_relaxed)) return false;
+        if (level >= highestThreshold.load(std::memory_order_relaxed)) return true;
+        return level >= TagThreshold(tag);
+    }
+    
+    // Runtime thresholds. LogLevel::Count means "off". Tags without an override use the global level.
+    void SetMinLevel(LogLevel level);
+    LogLevel GetMinLevel() const { return minLevel.load(std::memory_order_relaxed); }
+    void SetTagLevel(std::string_view tag, LogLevel level);
+    void ClearTagLevel(std::string_view tag);
+    LogLevel GetTagLevel(std::string_view tag) const;
+    // Per-route minimum for a tag, on top of its threshold. LogLevel::Count keeps the tag off
+    // that route. Defaults to Info (everything the threshold lets through).
+    void SetTagRoute(std::string_view tag, LogRoute route, LogLevel level);
+    LogLevel GetTagRoute(std::string_view tag, LogRoute route) const;
+    
+    // Tags are interned to small ids on first use; id 0 is "no tag". Past MaxTags distinct
+    // tags, new ones are logged untagged, with a one-time warning.
+    static constexpr size_t MaxTags = 256;
+    size_t GetTagCount() const { return tagCount.load(std::memory_order_acquire); }
+    const std::string& GetTagName(uint16_t tagId) const { return tags[tagId].name; }
+    
+    // UI display - index 0 is the oldest retained entry, formatting is left to the caller
+    const LogStore& GetStore() const { return store; }
+    static ImVec4 GetLevelColor(LogLevel level);
     void Clear();
     
+    // Search box syntax: free text (substring, any case) plus optional tag:NAME and level:LEVEL
+    LogQuery ParseQuery(std::string_view text) const;
+    // Ids of the matching history entries, oldest first
+    void Search(const LogQuery& query, std::vector<uint64_t>& ids);
+    
+    // Storm control stats: entries held back by the rate limit, and repeats folded into a count
+    size_t GetRateLimited() const { return rateLimited.load(std::memory_order_relaxed); }
+    size_t GetCollapsedRepeats() const { return collapsedRepeats; }
+    
+    // Async writer stats
+    size_t GetQueueStalls() const { return queueStalls.load(std::memory_order_relaxed); }
+    // Entries from other threads logged before Init or after Shutdown, with no staging ring to
+    // take them; these reach the file (when the writer thread runs) but not the history
+    size_t GetStagingDrops() const { return stagingDrops.load(std::memory_order_relaxed); }
+    
+    // Heap allocations made by the logging path itself (arena chunks, oversized queue
+    // records, line buffer growth). Stays flat once logging reaches steady state.
+    size_t GetHeapAllocations() const;
+    
+    // True for the rotating segment still being written, which can't be viewed safely
+    bool IsActiveLogFile(const std::string& path) const;
+    
 private:
     Logger() = default;
-    void AddEntry(const std::string& level, const std::string& message, 
-                 const std::string& tag, const ImVec4& color);
+    ~Logger() { Shutdown(); }
+    void AddEntry(LogLevel level, std::string_view message, std::string_view tag);
+    uint16_t InternTag(std::string_view tag);
+    int FindTag(std::string_view tag) const;
+    LogLevel TagThreshold(std::string_view tag) const;
+    bool Routed(LogLevel level, uint16_t tagId, LogRoute route) const {
+        return level >= (LogLevel)tags[tagId].routeLevel[(int)route].load(std::memory_order_relaxed);
+    }
+    bool ToHistory(LogLevel level, uint16_t tagId) const { return keepHistory && Routed(level, tagId, LogRoute::History); }
+    bool OnMainThread() const { return mainThread == std::thread::id() || std::this_thread::get_id() == mainThread; }
+    LogStaging* ThreadStaging();
+    void Stage(LogLevel level, uint16_t tagId, std::string_view message, const char* format = nullptr);
+    void MergeStaged();
+    void MergeRecord(const LogRecord& rec);
+    void UpdateThresholdBounds();
+    bool PassSite(LogSite& site, LogLevel level, std::string_view tag, std::string_view content, bool comparable);
+    bool Admit(LogSite& site);
+    void BeginEntry();
+    void FlushRepeats();
+    void ReportSuppressed();
+    void LogFormatV(LogLevel level, std::string_view tag, const char* fmt, va_list args);
+    void LogFormatUnchecked(LogLevel level, std::string_view tag, const char* fmt, ...);
+    std::string_view FormatMessageV(const char* fmt, va_list args);
+    void AppendHistory(int64_t timeMs, LogLevel level, uint16_t tagId, const char* fmt, ...);
+    int64_t OutputEncoded(LogLevel level, uint16_t tagId, const char* format, std::string_view args);
+    // File and console output, per the tag's routes. With a format, message holds that
+    // format's LogBinary-encoded arguments. recorded: already in the flight recorder (staged).
+    void Output(int64_t timeMs, LogLevel level, uint16_t tagId, std::string_view message,
+                const char* format = nullptr, bool recorded = false);
+    void PushToWriter(int64_t timeMs, LogLevel level, uint16_t tagId, std::string_view message,
+                      const char* format);
+    void RecordFlight(int64_t timeMs, LogLevel level, uint16_t tagId, std::string_view message,
+                      const char* format);
+    void WriterLoop();
+    void WriteQueued();
+    
+    LogStore store{ LoggerConfig().historyCapacity };
+    LogSearchIndex searchIndex;
+    
+    // Tag table. Slots below tagCount are published and their names never change, so lookups
+    // need no lock; adding a tag takes tagMutex. Names are found through a hash table of ids,
+    // 0 marking an empty slot.
+    struct TagInfo {
+        std::string name;
+        std::atomic<int8_t> level{ -1 };            // Threshold override, -1 = use minLevel
+        std::atomic<uint8_t> routeLevel[(int)LogRoute::Count] = {};   // Per-route minimum, Info by default
+        std::atomic<uint8_t> threshold{ 0 };        // Lowest level any route accepts, what IsEnabled tests
+    };
+    TagInfo tags[MaxTags];
+    std::atomic<size_t> tagCount{ 1 };
+    static constexpr size_t TagSlots = MaxTags * 2;
+    std::atomic<uint16_t> tagSlots[TagSlots] = {};
+    std::atomic<bool> tagsFull{ false };        // The warning about it has been logged
+    std::mutex tagMutex;
     
-    std::vector<std::string> entries;
-    std::vector<ImVec4> colors;
-    std::ofstream logFile;
-    bool initialized = false;
+    std::string lineBuffer;                     // Reused for console output
+    size_t lineBufferGrowths = 0;
+    std::string messageBuffer;                  // Formatted text when there is no history to hold it
+    size_t messageBufferGrowths = 0;
+    std::unique_ptr<LogSink> fileSink;      // FileSink, RotatingFileSink or BinaryFileSink, per config
+    RotatingFileSink* rotatingSink = nullptr;   // fileSink, when it rotates
+    LogFlightRecorder flightRecorder;
+    LogArchiver archiver;                   // Compresses closed segments when compressSegments is set
+    std::string crashDumpPath;
+    bool binaryOutput = false;
+    bool keepHistory = true;
+    std::atomic<bool> initialized{ false };     // Read by other threads before they stage
+    std::atomic<LogLevel> minLevel{ LogLevel::Info };
+    std::atomic<LogLevel> lowestThreshold{ LogLevel::Info };   // Min/max over minLevel and every tag override
+    std::atomic<LogLevel> highestThreshold{ LogLevel::Info };
+    
+    // Entries from other threads
+    std::thread::id mainThread;
+    mutable std::mutex stagingMutex;            // Guards the list, not the rings
+    std::vector<std::shared_ptr<LogStaging>> stagingBuffers;   // Shared with each thread's handle
+    std::atomic<size_t> stagingCapacity{ 0 };   // config.stagingCapacity, for other threads
+    std::vector<size_t> stagingPending;         // Per ring, entries left to take this merge
+    std::atomic<size_t> stagingDrops{ 0 };
+    size_t retiredStagingAllocations = 0;
+    
+    // Storm control. The repeat run is main-thread only; other threads just get the rate limit.
+    const LogSite* repeatSite = nullptr;        // Call site and content hash of the last entry,
+    uint64_t repeatHash = 0;                    // null when that wasn't a comparable macro entry
+    LogLevel repeatLevel = LogLevel::Info;
+    uint16_t repeatTagId = 0;
+    uint32_t repeatCount = 0;                   // Identical entries since, not yet reported
+    int64_t repeatStartMs = 0;
+    const LogSite* pendingSite = nullptr;       // Macro entry PassSite let through, not yet written
+    uint64_t pendingHash = 0;
+    LogLevel pendingLevel = LogLevel::Info;
+    uint16_t pendingTagId = 0;
+    bool writingSummary = false;
+    size_t collapsedRepeats = 0;
+    std::atomic<size_t> rateLimited{ 0 };
+    std::mutex suppressedMutex;
+    std::vector<LogSite*> suppressedSites;      // Sites with a nonzero suppressed count
+    std::vector<LogSite*> reportSites;
+    
+    // Async file output
+    LoggerConfig config;
+    LogQueue queue;
+    std::thread writer;
+    std::atomic<bool> writerRunning{ false };
+    std::atomic<bool> writerIdle{ false };
+    std::atomic<size_t> queueStalls{ 0 };
+    std::atomic<bool> frameFlushRequested{ false };
+    std::atomic<bool> crashing{ false };
+    std::mutex writerMutex;
+    std::condition_variable writerWake;
 };
 
+// Compile-time threshold: calls below LOG_COMPILE_LEVEL compile to nothing.
+// 0 = everything, 1 = warnings and errors, 2 = errors only, 3 = no logging.
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+#define LOG_NOOP() ((void)0)
+
+// Never called; gives the compiler a printf signature to check LOG_*F formats against
+void LogFormatCheck(const char* fmt, ...) IM_FMTARGS(1);
+inline void LogFormatCheck(const char*, ...) {}
+
+// Formatted macros, e.g. LOG_INFOF_TAG("GAME", "End of turn #%d", turn).
+// Arguments are not evaluated when the level/tag is filtered out. The format has to be a string
+// literal (pasting "" around it won't compile otherwise): binary logs key it by address, and
+// other threads hand the pointer to the writer.
+#define LOG_FORMAT_IMPL(level, tag, fmt, ...) \
+    do { \
+        static ClassGame::LogSite site_(__FILE__, __LINE__); \
+        ClassGame::Logger& logger_ = ClassGame::Logger::GetInstance(); \
+        if (logger_.IsEnabled(level, tag)) { \
+            if (false) ClassGame::LogFormatCheck("" fmt "" __VA_OPT__(,) __VA_ARGS__); \
+            logger_.LogArgs(site_, level, tag, "" fmt "" __VA_OPT__(,) __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_ENTRY_IMPL(level, msg, tag) \
+    do { \
+        static ClassGame::LogSite site_(__FILE__, __LINE__); \
+        ClassGame::Logger::GetInstance().Log(level, msg, tag, site_); \
+    } while (0)
+
 // Macros
-#define LOG_INFO(msg) ClassGame::Logger::GetInstance().Info(msg)
-#define LOG_INFO_TAG(msg, tag) ClassGame::Logger::GetInstance().Info(msg, tag)
-#define LOG_WARN(msg) ClassGame::Logger::GetInstance().Warning(msg)
-#define LOG_WARN_TAG(msg, tag) ClassGame::Logger::GetInstance().Warning(msg, tag)
-#define LOG_ERROR(msg) ClassGame::Logger::GetInstance().Error(msg)
-#define LOG_ERROR_TAG(msg, tag) ClassGame::Logger::GetInstance().Error(msg, tag)
-#define LOG_EVENT(msg) ClassGame::Logger::GetInstance().GameEvent(msg)
+#if LOG_COMPILE_LEVEL <= 0
+#define LOG_INFO(msg) LOG_ENTRY_IMPL(ClassGame::LogLevel::Info, msg, std::string_view())
+#define LOG_INFO_TAG(msg, tag) LOG_ENTRY_IMPL(ClassGame::LogLevel::Info, msg, tag)
+#define LOG_EVENT(msg) LOG_ENTRY_IMPL(ClassGame::LogLevel::Info, msg, "GAME")
+#define LOG_INFOF(...) LOG_FORMAT_IMPL(ClassGame::LogLevel::Info, std::string_view(), __VA_ARGS__)
+#define LOG_INFOF_TAG(tag, ...) LOG_FORMAT_IMPL(ClassGame::LogLevel::Info, tag, __VA_ARGS__)
+#else
+#define LOG_INFO(msg) LOG_NOOP()
+#define LOG_INFO_TAG(msg, tag) LOG_NOOP()
+#define LOG_EVENT(msg) LOG_NOOP()
+#define LOG_INFOF(...) LOG_NOOP()
+#define LOG_INFOF_TAG(tag, ...) LOG_NOOP()
+#endif
+
+#if LOG_COMPILE_LEVEL <= 1
+#define LOG_WARN(msg) LOG_ENTRY_IMPL(ClassGame::LogLevel::Warning, msg, std::string_view())
+#define LOG_WARN_TAG(msg, tag) LOG_ENTRY_IMPL(ClassGame::LogLevel::Warning, msg, tag)
+#define LOG_WARNF(...) LOG_FORMAT_IMPL(ClassGame::LogLevel::Warning, std::string_view(), __VA_ARGS__)
+#define LOG_WARNF_TAG(tag, ...) LOG_FORMAT_IMPL(ClassGame::LogLevel::Warning, tag, __VA_ARGS__)
+#else
+#define LOG_WARN(msg) LOG_NOOP()
+#define LOG_WARN_TAG(msg, tag) LOG_NOOP()
+#define LOG_WARNF(...) LOG_NOOP()
+#define LOG_WARNF_TAG(tag, ...) LOG_NOOP()
+#endif
+
+#if LOG_COMPILE_LEVEL <= 2
+#define LOG_ERROR(msg) LOG_ENTRY_IMPL(ClassGame::LogLevel::Error, msg, std::string_view())
+#define LOG_ERROR_TAG(msg, tag) LOG_ENTRY_IMPL(ClassGame::LogLevel::Error, msg, tag)
+#define LOG_ERRORF(...) LOG_FORMAT_IMPL(ClassGame::LogLevel::Error, std::string_view(), __VA_ARGS__)
+#define LOG_ERRORF_TAG(tag, ...) LOG_FORMAT_IMPL(ClassGame::LogLevel::Error, tag, __VA_ARGS__)
+#else
+#define LOG_ERROR(msg) LOG_NOOP()
+#define LOG_ERROR_TAG(msg, tag) LOG_NOOP()
+#define LOG_ERRORF(...) LOG_NOOP()
+#define LOG_ERRORF_TAG(tag, ...) LOG_NOOP()
+#endif
 
 }
\ No newline at end of file
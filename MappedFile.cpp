@@ -0,0 +1,168 @@
+#include "MappedFile.h"
+#include <cstdint>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ClassGame {
+
+#ifdef _WIN32
+
+bool MappedFile::Create(const std::string& path, size_t fileSize) {
+    Close();
+    handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                         nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == InvalidHandle())
+        return false;
+
+    mapping = CreateFileMappingA(handle, nullptr, PAGE_READWRITE,
+                                 (DWORD)((uint64_t)fileSize >> 32), (DWORD)fileSize, nullptr);
+    data = mapping ? (char*)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, fileSize) : nullptr;
+    if (!data) {
+        Close(0);
+        return false;
+    }
+    size = fileSize;
+    writable = true;
+    return true;
+}
+
+bool MappedFile::OpenRead(const std::string& path) {
+    Close();
+    handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                         nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == InvalidHandle())
+        return false;
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(handle, &fileSize);
+    size = (size_t)fileSize.QuadPart;
+    writable = false;
+    if (size == 0)
+        return true;
+
+    mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    data = mapping ? (char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!data) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Flush(bool async) {
+    if (!data || !writable)
+        return;
+    FlushViewOfFile(data, 0);
+    if (!async)
+        FlushFileBuffers(handle);
+}
+
+void MappedFile::Truncate(size_t newSize) {
+    // Windows won't shrink a file with a live mapping; Close(finalSize) handles it instead
+}
+
+void MappedFile::Close(size_t finalSize) {
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping)
+        CloseHandle(mapping);
+    data = nullptr;
+    mapping = nullptr;
+
+    if (handle != InvalidHandle()) {
+        if (writable && finalSize != (size_t)-1) {
+            LARGE_INTEGER end;
+            end.QuadPart = (LONGLONG)finalSize;
+            SetFilePointerEx(handle, end, nullptr, FILE_BEGIN);
+            SetEndOfFile(handle);
+        }
+        CloseHandle(handle);
+    }
+    handle = InvalidHandle();
+    size = 0;
+}
+
+#else
+
+bool MappedFile::Create(const std::string& path, size_t fileSize) {
+    Close();
+    handle = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (handle < 0)
+        return false;
+
+    if (ftruncate(handle, (off_t)fileSize) != 0) {
+        Close(0);
+        return false;
+    }
+    void* mapped = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0);
+    if (mapped == MAP_FAILED) {
+        Close(0);
+        return false;
+    }
+    data = (char*)mapped;
+    size = fileSize;
+    writable = true;
+    return true;
+}
+
+bool MappedFile::OpenRead(const std::string& path) {
+    Close();
+    handle = open(path.c_str(), O_RDONLY);
+    if (handle < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(handle, &info) != 0) {
+        Close();
+        return false;
+    }
+    size = (size_t)info.st_size;
+    writable = false;
+    if (size == 0)
+        return true;
+
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, handle, 0);
+    if (mapped == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    data = (char*)mapped;
+    return true;
+}
+
+void MappedFile::Flush(bool async) {
+    if (data && writable)
+        msync(data, size, async ? MS_ASYNC : MS_SYNC);
+}
+
+void MappedFile::Truncate(size_t newSize) {
+    if (handle >= 0 && writable)
+        (void)!ftruncate(handle, (off_t)newSize);
+}
+
+void MappedFile::Close(size_t finalSize) {
+    if (data)
+        munmap(data, size);
+    data = nullptr;
+
+    if (handle >= 0) {
+        if (writable && finalSize != (size_t)-1)
+            (void)!ftruncate(handle, (off_t)finalSize);
+        close(handle);
+    }
+    handle = InvalidHandle();
+    size = 0;
+}
+
+#endif
+
+}
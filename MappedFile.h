@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ClassGame {
+
+// Thin cross-platform wrapper over a memory-mapped file (mmap / MapViewOfFile)
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Create (or truncate) the file at the given size and map it read-write
+    bool Create(const std::string& path, size_t size);
+
+    // Map an existing file read-only. Empty files open successfully with Size() == 0.
+    bool OpenRead(const std::string& path);
+
+    // Ask the OS to write dirty pages back; async returns without waiting for the disk
+    void Flush(bool async = true);
+
+    // Shrink the file on disk without unmapping. Only uses calls that are OK in a signal handler.
+    void Truncate(size_t size);
+
+    // Unmap and close, optionally cutting the file down to the bytes actually used
+    void Close(size_t finalSize = (size_t)-1);
+
+    bool IsOpen() const { return handle != InvalidHandle(); }
+    char* Data() { return data; }
+    const char* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+#ifdef _WIN32
+    using Handle = void*;
+    static Handle InvalidHandle() { return (Handle)(intptr_t)-1; }
+    Handle mapping = nullptr;
+#else
+    using Handle = int;
+    static Handle InvalidHandle() { return -1; }
+#endif
+    Handle handle = InvalidHandle();
+    char* data = nullptr;
+    size_t size = 0;
+    bool writable = false;
+};
+
+}
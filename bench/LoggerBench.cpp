@@ -0,0 +1,227 @@
+// Throughput and latency of the logging calls themselves: Logger::Info/Warning/Error plus one
+// LOG_INFOF in every four calls, over the sink configurations the game can run with.
+// Each scenario first runs untimed for throughput, then again timing every call for p50/p99.
+// allocs/call counts every global operator new during the throughput pass (the bench replaces
+// it below); logger allocs is Logger::GetHeapAllocations, which also sees the malloc'd arena
+// chunks and oversized records. bytes are the size of the file left behind.
+// A scenario that loses entries (staging drops) fails and makes the exit status nonzero.
+// Build in Release: Debug builds also print every entry to the console.
+//
+//   logger_bench [calls per thread]
+#include "../Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ClassGame;
+
+// Every heap allocation made through new, from any thread
+static std::atomic<size_t> NewCalls{ 0 };
+
+static void* CountedAlloc(size_t size) {
+    NewCalls.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+static void* CountedAlignedAlloc(size_t size, std::align_val_t align) {
+    NewCalls.fetch_add(1, std::memory_order_relaxed);
+    size_t alignment = (size_t)align;
+    size = (size + alignment - 1) / alignment * alignment;
+#ifdef _WIN32
+    return _aligned_malloc(size ? size : alignment, alignment);
+#else
+    return aligned_alloc(alignment, size ? size : alignment);
+#endif
+}
+
+static void AlignedFree(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+void* operator new(size_t size) {
+    if (void* p = CountedAlloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+void* operator new(size_t size, std::align_val_t align) {
+    if (void* p = CountedAlignedAlloc(size, align))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size, std::align_val_t align) { return operator new(size, align); }
+void operator delete(void* p, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { AlignedFree(p); }
+
+struct Scenario {
+    const char* name;
+    int threads;
+    bool file;          // false: the bench tags are routed away from the file
+    bool async;
+    bool binary;
+};
+
+static const Scenario Scenarios[] = {
+    { "history only",      1, false, false, false },
+    { "text file, sync",   1, true,  false, false },
+    { "text file, async",  1, true,  true,  false },
+    { "binary, async",     1, true,  true,  true  },
+    { "history only",      4, false, false, false },
+    { "text file, async",  4, true,  true,  false },
+    { "binary, async",     4, true,  true,  true  },
+};
+
+static const int WarmupCalls = 20000;
+
+static const char* Messages[] = {
+    "Player moved to tile",
+    "Invalid move attempted",
+    "Enemy spawned near the north gate",
+    "Turn ended",
+};
+
+static inline void LogOne(Logger& logger, int i) {
+    switch (i & 3) {
+        case 0: logger.Info(Messages[(i >> 2) & 3], "BENCH"); break;
+        case 1: logger.Warning(Messages[(i >> 2) & 3]); break;
+        case 2: logger.Error(Messages[(i >> 2) & 3], "BENCH"); break;
+        default: LOG_INFOF_TAG("BENCH", "Unit %d moved to %d,%d", i, i & 63, (i >> 6) & 63); break;
+    }
+}
+
+// Runs calls per thread on threads workers; the calling thread plays the frame loop and merges
+// worker entries once a millisecond. latencies, when given, gets one sample per call.
+static double RunCalls(int threads, int calls, std::vector<std::vector<uint32_t>>* latencies) {
+    Logger& logger = Logger::GetInstance();
+    auto work = [&](int t) {
+        std::vector<uint32_t>* samples = latencies ? &(*latencies)[t] : nullptr;
+        for (int i = 0; i < calls; i++) {
+            if (samples) {
+                auto before = std::chrono::steady_clock::now();
+                LogOne(logger, i);
+                auto after = std::chrono::steady_clock::now();
+                (*samples)[i] = (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count();
+            }
+            else {
+                LogOne(logger, i);
+            }
+        }
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+    if (threads == 1) {
+        work(0);
+    }
+    else {
+        std::atomic<int> done{ 0 };
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++)
+            workers.emplace_back([&, t] { work(t); done.fetch_add(1); });
+        while (done.load() < threads) {
+            logger.EndFrame();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        for (auto& worker : workers)
+            worker.join();
+    }
+    logger.EndFrame();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+// Returns false when entries were lost
+static bool RunScenario(const Scenario& scenario, int calls) {
+    LoggerConfig config;
+    config.filename = "logger_bench.txt";
+    config.async = scenario.async;
+    config.binaryLog = scenario.binary;
+    config.installCrashHandlers = false;
+    config.collapseRepeats = false;     // Measure the logging path, not storm control
+    config.rateLimit = 0;
+    config.stagingCapacity = 8192;
+    std::string path = scenario.binary ? "logger_bench.bin" : "logger_bench.txt";
+
+    Logger& logger = Logger::GetInstance();
+    logger.Init(config);
+    LogLevel fileLevel = scenario.file ? LogLevel::Info : LogLevel::Count;
+    logger.SetTagRoute("", LogRoute::File, fileLevel);
+    logger.SetTagRoute("BENCH", LogRoute::File, fileLevel);
+
+    // Warm up so arena chunks and scratch buffers are already at steady-state size
+    RunCalls(scenario.threads, WarmupCalls, nullptr);
+    logger.Clear();
+
+    size_t heapBefore = logger.GetHeapAllocations();
+    size_t newBefore = NewCalls.load();
+    size_t dropsBefore = logger.GetStagingDrops();
+    double seconds = RunCalls(scenario.threads, calls, nullptr);
+    size_t newCalls = NewCalls.load() - newBefore;
+    size_t heapCalls = logger.GetHeapAllocations() - heapBefore;
+    size_t drops = logger.GetStagingDrops() - dropsBefore;
+
+    std::vector<std::vector<uint32_t>> latencies(scenario.threads, std::vector<uint32_t>(calls));
+    RunCalls(scenario.threads, calls, &latencies);
+
+    logger.SetTagRoute("", LogRoute::File, LogLevel::Info);
+    logger.SetTagRoute("BENCH", LogRoute::File, LogLevel::Info);
+    logger.Shutdown();
+
+    std::vector<uint32_t> all;
+    all.reserve((size_t)calls * scenario.threads);
+    for (const auto& samples : latencies)
+        all.insert(all.end(), samples.begin(), samples.end());
+    std::nth_element(all.begin(), all.begin() + all.size() / 2, all.end());
+    uint32_t p50 = all[all.size() / 2];
+    std::nth_element(all.begin(), all.begin() + all.size() * 99 / 100, all.end());
+    uint32_t p99 = all[all.size() * 99 / 100];
+
+    std::error_code error;
+    uintmax_t bytes = std::filesystem::file_size(path, error);
+    if (error)
+        bytes = 0;
+    std::filesystem::remove(path, error);
+
+    // Throughput counts only the calls that were logged; the file holds the warm-up and both passes
+    double total = (double)calls * scenario.threads;
+    double written = 2 * total + (double)WarmupCalls * scenario.threads;
+    printf("%-18s %2d  %9.2f  %7u  %7u  %11.4f  %13.4f  %10.1f  %zu%s\n", scenario.name, scenario.threads,
+           (total - (double)drops) / seconds / 1e6, p50, p99, newCalls / total, heapCalls / total, bytes / written,
+           drops, drops > 0 ? "  FAIL" : "");
+    return drops == 0;
+}
+
+int main(int argc, char** argv) {
+    int calls = argc > 1 ? atoi(argv[1]) : 200000;
+    if (calls <= 0) {
+        printf("usage: logger_bench [calls per thread]\n");
+        return 1;
+    }
+
+    printf("%d calls per thread, 1 in 4 formatted\n\n", calls);
+    printf("%-18s %2s  %9s  %7s  %7s  %11s  %13s  %10s  %s\n", "scenario", "th", "Mcalls/s", "p50 ns", "p99 ns",
+           "allocs/call", "logger allocs", "bytes/call", "staging drops");
+    bool passed = true;
+    for (const Scenario& scenario : Scenarios)
+        passed = RunScenario(scenario, calls) && passed;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+// CommandHistory against a plain vector model: random adds with case-folded repeats and
+// evictions, checked entry by entry and through Find, so the hash index's backward-shift
+// deletion is exercised on every eviction and repeat. Then the same through a history file
+// read back with LoadOlder.
+//
+//   command_history_test [scratch directory]
+#include "../CommandHistory.h"
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ClassGame;
+
+static int failures = 0;
+
+static void Check(bool ok, const char* what, size_t capacity, int step) {
+    if (!ok) {
+        printf("FAIL %s (capacity %zu, step %d)\n", what, capacity, step);
+        failures++;
+    }
+}
+
+static std::string Folded(std::string text) {
+    for (char& c : text)
+        c = (char)toupper((unsigned char)c);
+    return text;
+}
+
+// A small vocabulary so repeats are common, typed in random case
+static std::string RandomCommand(std::mt19937& rng) {
+    std::string command = "cmd" + std::to_string(rng() % 40);
+    if (rng() % 4 == 0)
+        command += " arg" + std::to_string(rng() % 3);
+    for (char& c : command) {
+        if (rng() % 2)
+            c = (char)toupper((unsigned char)c);
+    }
+    return command;
+}
+
+// Oldest first, each command once, with the casing it was last added with
+static void ModelAdd(std::vector<std::string>& model, const std::string& command, size_t capacity) {
+    for (size_t i = 0; i < model.size(); i++) {
+        if (Folded(model[i]) == Folded(command)) {
+            model.erase(model.begin() + i);
+            break;
+        }
+    }
+    model.push_back(command);
+    if (model.size() > capacity)
+        model.erase(model.begin());
+}
+
+static bool Matches(const CommandHistory& history, const std::vector<std::string>& model) {
+    if (history.Size() != model.size())
+        return false;
+    size_t i = 0;
+    for (int entry = history.Oldest(); entry >= 0; entry = history.Newer(entry), i++) {
+        if (i >= model.size() || model[i] != history.Text(entry))
+            return false;
+    }
+    return i == model.size();
+}
+
+static bool FindMatches(const CommandHistory& history, const std::vector<std::string>& model) {
+    for (int n = 0; n < 40; n++) {
+        for (int arg = -1; arg < 3; arg++) {
+            std::string command = "CMD" + std::to_string(n) + (arg < 0 ? "" : " ARG" + std::to_string(arg));
+            int entry = history.Find(command);
+            bool expected = false;
+            for (const std::string& kept : model)
+                expected |= Folded(kept) == command;
+            if ((entry >= 0) != expected || (entry >= 0 && Folded(history.Text(entry)) != command))
+                return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::filesystem::path dir = argc > 1 ? std::filesystem::path(argv[1]) : std::filesystem::temp_directory_path();
+    std::mt19937 rng(1234);
+
+    const size_t capacities[] = { 1, 2, 3, 7, 8, 16, 33, 100 };
+    for (size_t capacity : capacities) {
+        CommandHistory history(capacity);
+        std::vector<std::string> model;
+        for (int step = 0; step < 5000; step++) {
+            if (rng() % 1000 == 0) {
+                history.Clear();
+                model.clear();
+            }
+            std::string command = RandomCommand(rng);
+            history.Add(command);
+            ModelAdd(model, command, capacity);
+            Check(Matches(history, model), "entries", capacity, step);
+            if (step % 50 == 0)
+                Check(FindMatches(history, model), "find", capacity, step);
+        }
+    }
+
+    // A history file read back newest first fills the same entries, one LoadOlder at a time
+    std::string path = (dir / "command_history_test.txt").string();
+    for (size_t capacity : capacities) {
+        std::filesystem::remove(path);
+        std::vector<std::string> added;
+        {
+            CommandHistory history(capacity);
+            Check(history.Open(path), "open", capacity, 0);
+            for (int step = 0; step < 500; step++) {
+                added.push_back(RandomCommand(rng));
+                history.Add(added.back());
+            }
+        }
+
+        std::vector<std::string> model;
+        for (const std::string& command : added)
+            ModelAdd(model, command, capacity);
+
+        CommandHistory history(capacity);
+        Check(history.Open(path), "reopen", capacity, 0);
+        int loaded = 0;
+        while (history.LoadOlder())
+            loaded++;
+        Check((size_t)loaded == model.size(), "loaded count", capacity, loaded);
+        Check(Matches(history, model), "loaded entries", capacity, loaded);
+        Check(FindMatches(history, model), "loaded find", capacity, loaded);
+    }
+    std::filesystem::remove(path);
+
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
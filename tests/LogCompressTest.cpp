@@ -0,0 +1,143 @@
+// Round trips through LogCompress: blocks of every kind of content, whole files across block
+// boundaries, and damaged input that must be rejected rather than overrun.
+//
+//   log_compress_test [scratch directory]
+#include "../LogCompress.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ClassGame;
+
+static int failures = 0;
+
+static void Check(bool ok, const char* what, size_t size) {
+    if (!ok) {
+        printf("FAIL %s (%zu bytes)\n", what, size);
+        failures++;
+    }
+}
+
+static std::string LogText(size_t size, std::mt19937& rng) {
+    static const char* Words[] = { "[INFO]", "[WARN]", "[GAME]", "Player", "moved", "to", "tile", "turn", "ended" };
+    std::string text;
+    while (text.size() < size) {
+        char stamp[24];
+        snprintf(stamp, sizeof(stamp), "[12:%02u:%02u.%03u] ", (unsigned)(rng() % 60), (unsigned)(rng() % 60),
+                 (unsigned)(rng() % 1000));
+        text += stamp;
+        for (int i = 0; i < 6; i++) {
+            text += Words[rng() % 9];
+            text += ' ';
+        }
+        text += std::to_string(rng() % 1000);
+        text += '\n';
+    }
+    text.resize(size);
+    return text;
+}
+
+static std::string RandomBytes(size_t size, std::mt19937& rng) {
+    std::string bytes(size, '\0');
+    for (char& c : bytes)
+        c = (char)(rng() & 0xff);
+    return bytes;
+}
+
+static void CheckBlock(const std::string& raw, const char* what) {
+    std::vector<char> packed(LogCompress::CompressBound(raw.size()));
+    size_t stored = LogCompress::CompressBlock(raw.data(), raw.size(), packed.data());
+    Check(stored <= packed.size(), what, raw.size());
+    std::string unpacked(raw.size(), '\0');
+    size_t length = LogCompress::DecompressBlock(packed.data(), stored, unpacked.data(), unpacked.size());
+    Check(length == raw.size() && unpacked == raw, what, raw.size());
+
+    // One byte short of room must fail, not write past the end
+    if (!raw.empty()) {
+        size_t shortLength = LogCompress::DecompressBlock(packed.data(), stored, unpacked.data(), raw.size() - 1);
+        Check(shortLength == (size_t)-1, "decompress into a short buffer", raw.size());
+    }
+}
+
+static std::string ReadArchive(const std::string& path, bool& truncated) {
+    std::string text;
+    LogCompress::Reader reader;
+    truncated = !reader.Open(path);
+    const char* block;
+    size_t length;
+    while (!truncated && reader.Next(block, length))
+        text.append(block, length);
+    truncated = truncated || reader.Truncated();
+    return text;
+}
+
+static void CheckFile(const std::string& raw, const std::filesystem::path& dir, const char* what) {
+    std::string inPath = (dir / "log_compress_test.txt").string();
+    std::string outPath = inPath + LogCompress::Extension;
+    FILE* file = fopen(inPath.c_str(), "wb");
+    if (!file) {
+        Check(false, "create the input file", raw.size());
+        return;
+    }
+    fwrite(raw.data(), 1, raw.size(), file);
+    fclose(file);
+
+    Check(LogCompress::CompressFile(inPath, outPath), what, raw.size());
+    LogCompress::Reader reader;
+    Check(reader.Open(outPath) && reader.RawSize() == raw.size(), "raw size from the block headers", raw.size());
+    bool truncated;
+    std::string text = ReadArchive(outPath, truncated);
+    Check(!truncated && text == raw, what, raw.size());
+
+    // Cut the archive short: the reader stops at the damage instead of reading past it
+    if (!raw.empty()) {
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(outPath, error);
+        std::filesystem::resize_file(outPath, size - 1, error);
+        text = ReadArchive(outPath, truncated);
+        Check(truncated && text.size() < raw.size(), "truncated archive", raw.size());
+    }
+    std::error_code error;
+    std::filesystem::remove(inPath, error);
+    std::filesystem::remove(outPath, error);
+}
+
+int main(int argc, char** argv) {
+    std::filesystem::path dir = argc > 1 ? std::filesystem::path(argv[1]) : std::filesystem::temp_directory_path();
+    std::mt19937 rng(1234);
+
+    const size_t sizes[] = { 0, 1, 4, 12, 13, 100, 4095, LogCompress::BlockSize - 1, LogCompress::BlockSize };
+    for (size_t size : sizes) {
+        CheckBlock(LogText(size, rng), "log text block");
+        CheckBlock(RandomBytes(size, rng), "random block");
+        CheckBlock(std::string(size, 'a'), "repeated byte block");
+    }
+    for (int i = 0; i < 200; i++) {
+        size_t size = rng() % LogCompress::BlockSize;
+        CheckBlock(i % 2 ? LogText(size, rng) : RandomBytes(size, rng), "random sized block");
+    }
+
+    // Garbage must decode to an error or to at most the given capacity, never crash
+    for (int i = 0; i < 2000; i++) {
+        std::string garbage = RandomBytes(1 + rng() % 256, rng);
+        char out[512];
+        size_t length = LogCompress::DecompressBlock(garbage.data(), garbage.size(), out, sizeof(out));
+        Check(length == (size_t)-1 || length <= sizeof(out), "garbage block", garbage.size());
+    }
+
+    const size_t fileSizes[] = { 0, 10, LogCompress::BlockSize, LogCompress::BlockSize + 1, 5 * LogCompress::BlockSize / 2 };
+    for (size_t size : fileSizes) {
+        CheckFile(LogText(size, rng), dir, "log text file");
+        CheckFile(RandomBytes(size, rng), dir, "random file");
+    }
+
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
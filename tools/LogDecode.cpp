@@ -0,0 +1,78 @@
+// Turns a binary log (LoggerConfig::binaryLog) back into the text form game_log.txt uses:
+//   log_decode game_log.bin              print to stdout
+//   log_decode game_log.bin out.txt      write to a file
+// Compressed segments (LoggerConfig::compressSegments, game_log.0001.txt.glz) are streamed
+// back out as the original text the same way.
+#include "../LogBinary.h"
+#include "../LogCompress.h"
+#include "../LogFormat.h"
+#include <cstdio>
+#include <string>
+
+using namespace ClassGame;
+
+// One block at a time, so memory stays flat however large the archive is
+static int Decompress(LogCompress::Reader& archive, const char* outPath) {
+    FILE* out = outPath ? fopen(outPath, "wb") : stdout;
+    if (!out) {
+        fprintf(stderr, "log_decode: cannot create %s\n", outPath);
+        return 1;
+    }
+    const char* text;
+    size_t length;
+    while (archive.Next(text, length))
+        fwrite(text, 1, length, out);
+    if (out != stdout)
+        fclose(out);
+    if (archive.Truncated()) {
+        fprintf(stderr, "log_decode: stopped at a damaged or incomplete block\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s <log.bin | segment.glz> [out.txt]\n", argv[0]);
+        return 2;
+    }
+
+    LogCompress::Reader archive;
+    if (archive.Open(argv[1]))
+        return Decompress(archive, argc == 3 ? argv[2] : nullptr);
+
+    LogBinary::Reader reader;
+    if (!reader.Open(argv[1])) {
+        fprintf(stderr, "log_decode: cannot open %s\n", argv[1]);
+        return 1;
+    }
+    FILE* out = argc == 3 ? fopen(argv[2], "wb") : stdout;
+    if (!out) {
+        fprintf(stderr, "log_decode: cannot create %s\n", argv[2]);
+        return 1;
+    }
+
+    // Lines are batched so the text side costs about what game_log.txt would have
+    LogBinary::Reader::Entry entry;
+    std::string text;
+    size_t entries = 0;
+    while (reader.Next(entry)) {
+        AppendLogLine(text, entry.timeMs, entry.level, entry.tag, entry.message);
+        entries++;
+        if (text.size() >= 64 * 1024) {
+            fwrite(text.data(), 1, text.size(), out);
+            text.clear();
+        }
+    }
+    fwrite(text.data(), 1, text.size(), out);
+    if (out != stdout)
+        fclose(out);
+
+    if (reader.Sessions() == 0 && entries == 0) {
+        fprintf(stderr, "log_decode: %s is not a binary log\n", argv[1]);
+        return 1;
+    }
+    if (reader.Truncated())
+        fprintf(stderr, "log_decode: stopped at a damaged or incomplete record after %zu entries\n", entries);
+    return 0;
+}